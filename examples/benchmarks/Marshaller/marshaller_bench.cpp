@@ -0,0 +1,307 @@
+/**************************************************************************
+ *                                                                        *
+ *  HLS Connections Library                                               *
+ *                                                                        *
+ *  Software Version: 2026.2                                              *
+ *                                                                        *
+ *  Release Date    : Tue May 12 21:38:26 PDT 2026                        *
+ *  Release Type    : Production Release                                  *
+ *  Release Build   : 2026.2.0                                            *
+ *                                                                        *
+ *  Copyright 2026 Siemens                                                *
+ *                                                                        *
+ **************************************************************************
+ *  Licensed under the Apache License, Version 2.0 (the "License");       *
+ *  you may not use this file except in compliance with the License.      * 
+ *  You may obtain a copy of the License at                               *
+ *                                                                        *
+ *      http://www.apache.org/licenses/LICENSE-2.0                        *
+ *                                                                        *
+ *  Unless required by applicable law or agreed to in writing, software   * 
+ *  distributed under the License is distributed on an "AS IS" BASIS,     * 
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or       *
+ *  implied.                                                              * 
+ *  See the License for the specific language governing permissions and   * 
+ *  limitations under the License.                                        *
+ **************************************************************************
+ *                                                                        *
+ *  The most recent version of this package is available at github.       *
+ *                                                                        *
+ *************************************************************************/
+
+//*****************************************************************************************
+// marshaller_bench.cpp
+//
+// Microbenchmark for Marshaller<Size> pack (message -> sc_lv bits) and unpack
+// (sc_lv bits -> message) over representative message shapes and widths.
+//
+// Usage:
+//   ./sim_sc [--csv | --json] [--min-time <seconds>] [--filter <substring>]
+//
+// The default output is a human readable table. --csv and --json print one record per
+// benchmark and operation with the fields:
+//   name, width (bits), op (pack|unpack), iterations, ns_per_op, bytes_per_sec
+//*****************************************************************************************
+
+#include <systemc.h>
+// ac types must be included before marshaller.h so the matching Wrapped<>
+// specializations are enabled.
+#include <ac_int.h>
+#include <ac_fixed.h>
+#include <ac_float.h>
+#include <ac_complex.h>
+#include <ac_array.h>
+#include <auto_gen_fields.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+//------------------------------------------------------------------------
+// Nested AUTO_GEN message types
+//------------------------------------------------------------------------
+
+struct Header {
+  ac_int<8, false> dest;
+  ac_int<4, false> vc;
+  bool last;
+
+  AUTO_GEN_FIELD_METHODS(Header, ( \
+     dest \
+   , vc \
+   , last \
+  ) )
+};
+
+struct Packet {
+  Header hdr;
+  ac_int<64, false> payload[4];
+  ac_fixed<16, 8, true> scale;
+
+  AUTO_GEN_FIELD_METHODS(Packet, ( \
+     hdr \
+   , payload \
+   , scale \
+  ) )
+};
+
+struct Burst {
+  Packet pkts[8];
+  sc_uint<32> tag;
+
+  AUTO_GEN_FIELD_METHODS(Burst, ( \
+     pkts \
+   , tag \
+  ) )
+};
+
+//------------------------------------------------------------------------
+// Benchmark harness
+//------------------------------------------------------------------------
+
+enum output_format_t { FORMAT_TABLE, FORMAT_CSV, FORMAT_JSON };
+
+struct bench_options {
+  output_format_t format;
+  double min_time;     // seconds per measurement
+  std::string filter;  // only run benchmarks whose name contains this
+  bench_options() : format(FORMAT_TABLE), min_time(0.2) {}
+};
+
+struct bench_result {
+  std::string name;
+  unsigned int width;
+  std::string op;
+  unsigned long iterations;
+  double ns_per_op;
+  double bytes_per_sec;
+};
+
+static const unsigned int pool_size = 64;
+
+typedef std::chrono::steady_clock bench_clock;
+
+template <class T>
+class marshaller_bench
+{
+public:
+  typedef Wrapped<T> WType;
+  static const unsigned int width = WType::width;
+  typedef sc_lv<width> Bits;
+
+  explicit marshaller_bench(const std::string &name) : name(name) {
+    marshall_width_check<T>::check();
+    // Build the value pool by unmarshalling random bit patterns, so every message
+    // shape gets legal values without type specific generators.
+    std::mt19937 rng(width);
+    for (unsigned int i = 0; i < pool_size; i++) {
+      Bits b;
+      for (unsigned int j = 0; j < width; j++) {
+        b[j] = sc_logic((rng() & 1) != 0);
+      }
+      Marshaller<width> m(b);
+      WType w;
+      w.Marshall(m);
+      vals.push_back(w);
+      Marshaller<width> mp;
+      w.Marshall(mp);
+      bits.push_back(mp.GetResult());
+    }
+    bits_out.resize(pool_size);
+    vals_out.resize(pool_size);
+  }
+
+  void run(const bench_options &opt, std::vector<bench_result> &results) {
+    if (name.find(opt.filter) == std::string::npos) { return; }
+    results.push_back(measure("pack", &marshaller_bench::pack, opt));
+    results.push_back(measure("unpack", &marshaller_bench::unpack, opt));
+    verify();
+  }
+
+private:
+  std::string name;
+  std::vector<WType> vals;
+  std::vector<Bits> bits;
+  std::vector<Bits> bits_out;
+  std::vector<WType> vals_out;
+
+  void pack(unsigned long iters) {
+    for (unsigned long i = 0; i < iters; i++) {
+      unsigned int idx = i % pool_size;
+      Marshaller<width> m;
+      vals[idx].Marshall(m);
+      bits_out[idx] = m.GetResult();
+    }
+  }
+
+  void unpack(unsigned long iters) {
+    for (unsigned long i = 0; i < iters; i++) {
+      unsigned int idx = i % pool_size;
+      Marshaller<width> m(bits[idx]);
+      vals_out[idx].Marshall(m);
+    }
+  }
+
+  bench_result measure(const char *op, void (marshaller_bench::*fn)(unsigned long),
+                       const bench_options &opt) {
+    // Warm up, then double the iteration count until one run takes at least min_time.
+    (this->*fn)(pool_size);
+    unsigned long iters = pool_size;
+    double secs = 0;
+    while (true) {
+      bench_clock::time_point start = bench_clock::now();
+      (this->*fn)(iters);
+      secs = std::chrono::duration<double>(bench_clock::now() - start).count();
+      if (secs >= opt.min_time || iters >= (1ul << 40)) { break; }
+      iters *= 2;
+    }
+    bench_result r;
+    r.name = name;
+    r.width = width;
+    r.op = op;
+    r.iterations = iters;
+    r.ns_per_op = secs * 1e9 / iters;
+    r.bytes_per_sec = (width / 8.0) * iters / secs;
+    return r;
+  }
+
+  // Round trip check, also keeps the benchmark loops' results observable.
+  void verify() {
+    for (unsigned int i = 0; i < pool_size; i++) {
+      Marshaller<width> m;
+      vals_out[i].Marshall(m);
+      Bits b = m.GetResult();
+      if (!(b == bits[i]) || !(bits_out[i] == bits[i])) {
+        std::cerr << "marshaller_bench: round trip mismatch for " << name << std::endl;
+        std::exit(1);
+      }
+    }
+  }
+};
+
+template <class T>
+void run_bench(const std::string &name, const bench_options &opt, std::vector<bench_result> &results)
+{
+  marshaller_bench<T> b(name);
+  b.run(opt, results);
+}
+
+static void print_results(const std::vector<bench_result> &results, output_format_t format)
+{
+  if (format == FORMAT_CSV) {
+    std::cout << "name,width,op,iterations,ns_per_op,bytes_per_sec\n";
+    for (unsigned int i = 0; i < results.size(); i++) {
+      const bench_result &r = results[i];
+      std::cout << "\"" << r.name << "\"," << r.width << "," << r.op << "," << r.iterations << ","
+                << r.ns_per_op << "," << r.bytes_per_sec << "\n";
+    }
+  } else if (format == FORMAT_JSON) {
+    std::cout << "{\n  \"benchmark\": \"marshaller\",\n  \"results\": [\n";
+    for (unsigned int i = 0; i < results.size(); i++) {
+      const bench_result &r = results[i];
+      std::cout << "    {\"name\": \"" << r.name << "\", \"width\": " << r.width
+                << ", \"op\": \"" << r.op << "\", \"iterations\": " << r.iterations
+                << ", \"ns_per_op\": " << r.ns_per_op << ", \"bytes_per_sec\": " << r.bytes_per_sec
+                << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    std::cout << "  ]\n}\n";
+  } else {
+    std::cout << std::left << std::setw(32) << "name" << std::right << std::setw(7) << "width"
+              << std::setw(8) << "op" << std::setw(14) << "ns/op" << std::setw(14) << "MB/s" << "\n";
+    for (unsigned int i = 0; i < results.size(); i++) {
+      const bench_result &r = results[i];
+      std::cout << std::left << std::setw(32) << r.name << std::right << std::setw(7) << r.width
+                << std::setw(8) << r.op << std::setw(14) << std::fixed << std::setprecision(2)
+                << r.ns_per_op << std::setw(14) << r.bytes_per_sec / 1e6 << "\n";
+    }
+  }
+}
+
+int sc_main(int argc, char *argv[])
+{
+  bench_options opt;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--csv")) { opt.format = FORMAT_CSV; }
+    else if (!strcmp(argv[i], "--json")) { opt.format = FORMAT_JSON; }
+    else if (!strcmp(argv[i], "--min-time") && (i + 1 < argc)) { opt.min_time = atof(argv[++i]); }
+    else if (!strcmp(argv[i], "--filter") && (i + 1 < argc)) { opt.filter = argv[++i]; }
+    else {
+      std::cerr << "usage: " << argv[0] << " [--csv | --json] [--min-time <seconds>] [--filter <substring>]\n";
+      return 1;
+    }
+  }
+
+  std::vector<bench_result> results;
+
+  run_bench<bool>("bool", opt, results);
+
+  run_bench<sc_uint<8> >("sc_uint<8>", opt, results);
+  run_bench<sc_uint<32> >("sc_uint<32>", opt, results);
+  run_bench<sc_uint<64> >("sc_uint<64>", opt, results);
+
+  run_bench<ac_int<8, false> >("ac_int<8>", opt, results);
+  run_bench<ac_int<64, false> >("ac_int<64>", opt, results);
+  run_bench<ac_int<256, false> >("ac_int<256>", opt, results);
+  run_bench<ac_int<1024, false> >("ac_int<1024>", opt, results);
+  run_bench<ac_int<4096, false> >("ac_int<4096>", opt, results);
+  run_bench<ac_int<8192, false> >("ac_int<8192>", opt, results);
+
+  run_bench<ac_fixed<16, 8, true> >("ac_fixed<16,8>", opt, results);
+  run_bench<ac_fixed<64, 32, true> >("ac_fixed<64,32>", opt, results);
+  run_bench<ac_float<16, 2, 8> >("ac_float<16,2,8>", opt, results);
+  run_bench<ac_complex<ac_fixed<16, 8, true> > >("ac_complex<ac_fixed<16,8>>", opt, results);
+  run_bench<ac_array<ac_int<32, false>, 8> >("ac_array<ac_int<32>,8>", opt, results);
+  run_bench<ac_array<ac_int<32, false>, 256> >("ac_array<ac_int<32>,256>", opt, results);
+
+  run_bench<Header>("struct Header", opt, results);
+  run_bench<Packet>("struct Packet", opt, results);
+  run_bench<Burst>("struct Burst", opt, results);
+
+  print_results(results, opt.format);
+  return 0;
+}
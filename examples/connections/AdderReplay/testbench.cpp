@@ -0,0 +1,245 @@
+/**************************************************************************
+ *                                                                        *
+ *  HLS Connections Library                                               *
+ *                                                                        *
+ *  Software Version: 2026.2                                              *
+ *                                                                        *
+ *  Release Date    : Tue May 12 21:38:26 PDT 2026                        *
+ *  Release Type    : Production Release                                  *
+ *  Release Build   : 2026.2.0                                            *
+ *                                                                        *
+ *  Copyright 2026 Siemens                                                *
+ *                                                                        *
+ **************************************************************************
+ *  Licensed under the Apache License, Version 2.0 (the "License");       *
+ *  you may not use this file except in compliance with the License.      * 
+ *  You may obtain a copy of the License at                               *
+ *                                                                        *
+ *      http://www.apache.org/licenses/LICENSE-2.0                        *
+ *                                                                        *
+ *  Unless required by applicable law or agreed to in writing, software   * 
+ *  distributed under the License is distributed on an "AS IS" BASIS,     * 
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or       *
+ *  implied.                                                              * 
+ *  See the License for the specific language governing permissions and   * 
+ *  limitations under the License.                                        *
+ **************************************************************************
+ *                                                                        *
+ *  The most recent version of this package is available at github.       *
+ *                                                                        *
+ *************************************************************************/
+
+//*****************************************************************************************
+// testbench.cpp
+//
+// Record and replay of the Adder example with binary channel logs.
+//
+//   ./sim_sc record   runs Adder with its sources and sink, logs every channel to
+//                     adder_data.clog and adder_names.txt (CHANNEL_LOG_INDEXED), and
+//                     writes the channels at the Adder's boundary to adder_boundary.txt,
+//                     found with replay_boundary(). replay_boundary() relies on the port
+//                     markers of MARSHALL_PORT ports, the Makefile forces that port type.
+//   ./sim_sc replay   runs the Adder alone: ReplaySources drive a_in and b_in with the
+//                     recorded messages, a ReplayChecker compares sum_out against the
+//                     recording, cycle by cycle (check_timing). Any data or timing
+//                     mismatch makes it exit with 1.
+//
+// Both modes use the same clock and reset, and the sink in the recording is always ready like
+// the ReplayChecker, so the Adder sends each sum in the same cycle as recorded.
+//*****************************************************************************************
+
+#include "Adder.h"
+#include <connections/replay.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// Clock and reset shared by both modes.
+SC_MODULE (clk_rst)
+{
+  sc_clock clk;
+  sc_signal<bool> rst;
+
+  SC_CTOR(clk_rst) :
+    clk("clk", 1, SC_NS, 0.5, 0, SC_NS, true),
+    rst("rst") {
+    SC_THREAD(run);
+  }
+
+  void run() {
+    rst = 1;
+    wait(10.5, SC_NS);
+    rst = 0;
+    wait(1, SC_NS);
+    rst = 1;
+    wait(1000, SC_NS);
+    sc_stop();
+  }
+};
+
+//------------------------------------------------------------------------
+// Record: the Adder in its full testbench
+//------------------------------------------------------------------------
+
+SC_MODULE (Source)
+{
+  Connections::Out<Adder::Data> x_out;
+  sc_in<bool> clk;
+  sc_in<bool> rst;
+  const int start_val;
+
+  void run() {
+    x_out.Reset();
+    Adder::Data x = start_val;
+    wait(20.0, SC_NS);
+    wait();
+    while (1) {
+      x_out.Push(x);
+      x = x * 3 + 1;
+      // Irregular gaps, so the replay has to reproduce the timing of the recording.
+      for (int i = 0; i < (int)(x % 3); i++) { wait(); }
+      wait();
+    }
+  }
+
+  SC_HAS_PROCESS(Source);
+  Source(sc_module_name name_, int start_val_) :
+    sc_module(name_), x_out("x_out"), clk("clk"), rst("rst"), start_val(start_val_) {
+    SC_THREAD(run);
+    sensitive << clk.pos();
+    async_reset_signal_is(rst, false);
+  }
+};
+
+SC_MODULE (Sink)
+{
+  Connections::In<Adder::Data> sum_in;
+  sc_in<bool> clk;
+  sc_in<bool> rst;
+  unsigned long count;
+
+  void run() {
+    sum_in.Reset();
+    wait(20.0, SC_NS);
+    wait();
+    while (1) {
+      sum_in.Pop();
+      count++;
+      wait();
+    }
+  }
+
+  SC_HAS_PROCESS(Sink);
+  Sink(sc_module_name name_) : sc_module(name_), sum_in("sum_in"), clk("clk"), rst("rst"), count(0) {
+    SC_THREAD(run);
+    sensitive << clk.pos();
+    async_reset_signal_is(rst, false);
+  }
+};
+
+SC_MODULE (record_tb)
+{
+  clk_rst cr;
+  Adder adder;
+  Source srca, srcb;
+  Sink sink;
+  Connections::Combinational<Adder::Data> a, b, sum;
+
+  SC_CTOR(record_tb) :
+    cr("cr"), adder("adder"), srca("srca", 7), srcb("srcb", 13), sink("sink"), a("a"), b("b"), sum("sum") {
+    adder.clk(cr.clk);  adder.rst(cr.rst);
+    srca.clk(cr.clk);   srca.rst(cr.rst);
+    srcb.clk(cr.clk);   srcb.rst(cr.rst);
+    sink.clk(cr.clk);   sink.rst(cr.rst);
+
+    srca.x_out(a);
+    srcb.x_out(b);
+    adder.a_in(a);
+    adder.b_in(b);
+    adder.sum_out(sum);
+    sink.sum_in(sum);
+  }
+
+  // Port bindings are complete once elaboration is, list the Adder's boundary then.
+  void start_of_simulation() {
+    std::ofstream boundary("adder_boundary.txt");
+    std::vector<Connections::replay_port> ports = Connections::replay_boundary(adder);
+    for (unsigned i = 0; i < ports.size(); i++) {
+      boundary << (ports[i].is_input ? "in " : "out ") << ports[i].port_name << " " << ports[i].channel_name << "\n";
+      std::cout << (ports[i].is_input ? "in  " : "out ") << ports[i].port_name << " <- " << ports[i].channel_name << std::endl;
+    }
+  }
+};
+
+//------------------------------------------------------------------------
+// Replay: the Adder alone, between a ReplaySource per input and a ReplayChecker
+//------------------------------------------------------------------------
+
+// Channel the Adder port basename was bound to in the recording, from adder_boundary.txt.
+static std::string boundary_channel(const std::string &port)
+{
+  std::ifstream ifs("adder_boundary.txt");
+  std::string dir, port_name, channel_name;
+  while (ifs >> dir >> port_name >> channel_name) {
+    if (port_name.find(".adder." + port) != std::string::npos) { return channel_name; }
+  }
+  std::cerr << "No channel for port " << port << " in adder_boundary.txt, run './sim_sc record' first" << std::endl;
+  exit(1);
+}
+
+SC_MODULE (replay_tb)
+{
+  clk_rst cr;
+  Adder adder;
+  Connections::ReplaySource<Adder::Data> srca, srcb;
+  Connections::ReplayChecker<Adder::Data> chk;
+  Connections::Combinational<Adder::Data> a, b, sum;
+
+  SC_CTOR(replay_tb) :
+    cr("cr"), adder("adder"),
+    srca("srca", "adder_data.clog", "adder_names.txt", boundary_channel("a_in")),
+    srcb("srcb", "adder_data.clog", "adder_names.txt", boundary_channel("b_in")),
+    chk("chk", "adder_data.clog", "adder_names.txt", boundary_channel("sum_out"), true),
+    a("a"), b("b"), sum("sum") {
+    adder.clk(cr.clk);  adder.rst(cr.rst);
+    srca.clk(cr.clk);   srca.rst(cr.rst);
+    srcb.clk(cr.clk);   srcb.rst(cr.rst);
+    chk.clk(cr.clk);    chk.rst(cr.rst);
+
+    srca.out(a);
+    srcb.out(b);
+    adder.a_in(a);
+    adder.b_in(b);
+    adder.sum_out(sum);
+    chk.in(sum);
+  }
+};
+
+int sc_main(int argc, char *argv[])
+{
+  if (argc != 2 || (strcmp(argv[1], "record") != 0 && strcmp(argv[1], "replay") != 0)) {
+    std::cerr << "usage: " << argv[0] << " record | replay" << std::endl;
+    return 1;
+  }
+
+  if (strcmp(argv[1], "record") == 0) {
+    record_tb tb("tb");
+
+    channel_logs logs;
+    if (logs.enable("adder", false, CHANNEL_LOG_INDEXED)) { return 1; }
+    logs.log_hierarchy(tb);
+
+    sc_start();
+    std::cout << "Recorded " << tb.sink.count << " sums" << std::endl;
+    return 0;
+  }
+
+  replay_tb tb("tb");
+  sc_start();
+  std::cout << "Replayed " << tb.srca.sent() << "/" << tb.srca.size() << " a, " << tb.srcb.sent() << "/" << tb.srcb.size()
+            << " b, checked " << tb.chk.checked() << "/" << tb.chk.size() << " sums, " << tb.chk.errors() << " mismatches, "
+            << tb.chk.timing_errors() << " timing mismatches" << std::endl;
+  return (tb.chk.errors() == 0 && tb.chk.timing_errors() == 0 && tb.chk.done()) ? 0 : 1;
+}
@@ -76,7 +76,12 @@
 */
 
 #include <boost/preprocessor/list/for_each.hpp>
+#include <boost/preprocessor/list/for_each_i.hpp>
+#include <boost/preprocessor/list/at.hpp>
 #include <boost/preprocessor/tuple/to_list.hpp>
+#include <boost/preprocessor/control/if.hpp>
+#include <boost/preprocessor/arithmetic/dec.hpp>
+#include <boost/preprocessor/cat.hpp>
 #include <connections/marshaller.h>
 #include <UIntOrEmpty.h>
 
@@ -360,6 +365,98 @@ public:
 };
 
 
+// Field descriptors
+//
+// AUTO_GEN_FIELD_METHODS generates one descriptor struct per field, named
+// auto_gen_field_<name>, holding the field type and its width and bit offset in the
+// marshalled bits (fields are marshalled in declaration order starting at bit 0).
+// The descriptors let a single field be read or written directly in marshalled
+// sc_lv or sc_bv bits, without unmarshalling the whole message:
+//
+//   sc_lv<Flit::width> bits = ...;
+//   auto dest = get_marshalled_field<AUTO_GEN_FIELD(Flit, dest)>(bits);
+//   set_marshalled_field<AUTO_GEN_FIELD(Flit, vc)>(bits, new_vc);
+//
+// Fields of nested AUTO_GEN structs are reached with auto_gen_nested_field:
+//
+//   typedef auto_gen_nested_field<AUTO_GEN_FIELD(Flit, hdr), AUTO_GEN_FIELD(Header, dest)> FlitDest;
+
+#define AUTO_GEN_FIELD(THIS_TYPE, F) THIS_TYPE::auto_gen_field_##F
+
+template <class Outer, class Inner>
+struct auto_gen_nested_field {
+  typedef typename Inner::type type;
+  static const unsigned int width = Inner::width;
+  static const unsigned int offset = Outer::offset + Inner::offset;
+};
+
+// Implementation of get/set_marshalled_field() for either marshalled bit vector type:
+// sc_lv, or sc_bv on MARSHALL_PORT signals with CONNECTIONS_MARSHALL_2STATE.
+template <class Field, int W, class Bits>
+inline void auto_gen_get_field(const Bits &bits, typename Field::type &val)
+{
+  static_assert(Field::width > 0, "Cannot access a zero width field");
+  static_assert(Field::offset + Field::width <= (unsigned int)W, "Field does not fit in the marshalled bits");
+  sc_lv<Field::width> fbits = bits.range(Field::offset + Field::width - 1, Field::offset);
+  Marshaller<Field::width> m(fbits);
+  type_traits<typename Field::type>::Marshall(m, val);
+}
+
+template <class Field, int W, class Bits>
+inline void auto_gen_set_field(Bits &bits, const typename Field::type &val)
+{
+  static_assert(Field::width > 0, "Cannot access a zero width field");
+  static_assert(Field::offset + Field::width <= (unsigned int)W, "Field does not fit in the marshalled bits");
+  Marshaller<Field::width> m;
+  // Marshalling only reads the field, the cast is needed since Marshall() is shared
+  // with the unmarshalling direction.
+  type_traits<typename Field::type>::Marshall(m, const_cast<typename Field::type &>(val));
+  bits.range(Field::offset + Field::width - 1, Field::offset) = m.GetResult();
+}
+
+// Read one field out of marshalled bits. The reference form also handles array fields.
+template <class Field, int W>
+inline void get_marshalled_field(const sc_lv<W> &bits, typename Field::type &val)
+{
+  auto_gen_get_field<Field, W>(bits, val);
+}
+
+template <class Field, int W>
+inline void get_marshalled_field(const sc_bv<W> &bits, typename Field::type &val)
+{
+  auto_gen_get_field<Field, W>(bits, val);
+}
+
+template <class Field, int W>
+inline typename Field::type get_marshalled_field(const sc_lv<W> &bits)
+{
+  typename Field::type val;
+  auto_gen_get_field<Field, W>(bits, val);
+  return val;
+}
+
+template <class Field, int W>
+inline typename Field::type get_marshalled_field(const sc_bv<W> &bits)
+{
+  typename Field::type val;
+  auto_gen_get_field<Field, W>(bits, val);
+  return val;
+}
+
+// Overwrite one field in marshalled bits, leaving all other bits unchanged.
+template <class Field, int W>
+inline void set_marshalled_field(sc_lv<W> &bits, const typename Field::type &val)
+{
+  auto_gen_set_field<Field, W>(bits, val);
+}
+
+template <class Field, int W>
+inline void set_marshalled_field(sc_bv<W> &bits, const typename Field::type &val)
+{
+  auto_gen_set_field<Field, W>(bits, val);
+}
+
+
 #define GEN_MARSHALL_FIELD(R, _, F) \
    type_traits<decltype(F)>::Marshall(m, F); 
    //
@@ -425,6 +522,26 @@ public:
   //
 
 
+#define GEN_FIELD_DESC_NAME(F) BOOST_PP_CAT(auto_gen_field_, F)
+
+#define GEN_FIELD_OFFSET(FIELDS, I) \
+  BOOST_PP_IF(I, GEN_FIELD_DESC_NAME(BOOST_PP_LIST_AT(FIELDS, BOOST_PP_DEC(I)))::offset + \
+                 GEN_FIELD_DESC_NAME(BOOST_PP_LIST_AT(FIELDS, BOOST_PP_DEC(I)))::width, 0)
+  //
+
+#define GEN_FIELD_DESC(R, FIELDS, I, F) \
+  struct GEN_FIELD_DESC_NAME(F) { \
+    typedef decltype(F) type; \
+    static const unsigned int width = calc_bit_width<type>::width; \
+    static const unsigned int offset = GEN_FIELD_OFFSET(FIELDS, I); \
+  };
+  //
+
+#define GEN_FIELD_DESCS(FIELDS) \
+  BOOST_PP_LIST_FOR_EACH_I(GEN_FIELD_DESC, FIELDS, FIELDS)
+  //
+
+
 #define FIELD_LIST(X) BOOST_PP_TUPLE_TO_LIST(BOOST_PP_TUPLE_SIZE(X), X )
 
 #define AUTO_GEN_FIELD_METHODS(THIS_TYPE, X) \
@@ -435,7 +552,8 @@ public:
   GEN_INFO_METHOD(FIELD_LIST(X)) \
   GEN_STREAM_METHOD(FIELD_LIST(X)) \
   GEN_WIDTH(FIELD_LIST(X)) \
-  GEN_EQUAL(FIELD_LIST(X))
+  GEN_EQUAL(FIELD_LIST(X)) \
+  GEN_FIELD_DESCS(FIELD_LIST(X))
   //
 
 #define AUTO_GEN_FIELD_METHODS_V2(THIS_TYPE, X) \
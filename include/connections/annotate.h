@@ -30,21 +30,172 @@
 
 #include <iostream>
 #include <string>
+#include <cstring>
+#include <cmath>
+#include <unordered_map>
+#include <memory>
+#include <thread>
+#include <cstdio>
 
 #include "connections.h"
 
 #include <rapidjson/document.h>
 #include <rapidjson/prettywriter.h>
+#include <rapidjson/writer.h>
 #include <rapidjson/ostreamwrapper.h>
 #include <rapidjson/istreamwrapper.h>
+#include <rapidjson/filewritestream.h>
 
 namespace Connections
 {
 
-#ifdef CONNECTIONS_ACCURATE_SIM
+  // Flags for set_annotate_output(), may be or'ed together.
+  enum annotate_output_flags {
+    ANNOTATE_OUTPUT_PRETTY         = 0,  // Indented output.json (default).
+    ANNOTATE_OUTPUT_COMPACT        = 1,  // No whitespace.
+    ANNOTATE_OUTPUT_ANNOTATED_ONLY = 2,  // Skip channels that are plain wires and not listed in input.json.
+    ANNOTATE_OUTPUT_DEFERRED       = 4,  // Write from a background thread, annotate_design() returns right away.
+    ANNOTATE_OUTPUT_NONE           = 8   // Don't write output.json.
+  };
+
+#ifdef CONNECTIONS_SIM_ONLY
+
+  // Name of a port as written to the JSON file: root_name and the valid signal suffix are
+  // removed, and ModelSim path separators are mapped to '.'.
+  inline std::string __annotate_port_name(std::string name, const std::string &root_name)
+  {
+    if ((name.length() >= 4) && (name.compare(name.length() - 4, 4, "_" _VLDNAMESTR_) == 0)) { name.erase(name.length() - 4, 4); }
+    std::size_t pos = name.find(root_name);
+    if (pos != std::string::npos) { name.erase(pos, root_name.length()); }
+#ifdef MTI_SYSTEMC
+    for (size_t i=0; i<name.length(); i++) { if (name[i]=='/') { name[i]='.'; } }
+#endif
+    return name;
+  }
+
+  // Name of a channel relative to root_name. Returns false if the channel is not below root_name.
+  inline bool __annotate_channel_name(const char *full_name, const std::string &root_name, std::string &rel_name)
+  {
+    // Fast path, channel names normally start with root_name.
+    if (strncmp(full_name, root_name.c_str(), root_name.length()) == 0) {
+      rel_name.assign(full_name + root_name.length());
+      return true;
+    }
+    rel_name.assign(full_name);
+    std::size_t pos = rel_name.find(root_name);
+    if (pos == std::string::npos) { return false; }
+    rel_name.erase(pos, root_name.length());
+    return true;
+  }
+
+  // Return an integer member of a channel, adding it with value def if it doesn't exist yet.
+  inline int __annotate_int_member(rapidjson::Value &v_channel, const char *member, int def, rapidjson::Document &d)
+  {
+    rapidjson::Value::MemberIterator m = v_channel.FindMember(member);
+    if (m == v_channel.MemberEnd()) {
+      rapidjson::Value v_int;
+      v_int.SetInt(def);
+      v_channel.AddMember(rapidjson::StringRef(member), v_int, d.GetAllocator());
+      return def;
+    }
+    assert(m->value.IsInt());
+    return m->value.GetInt();
+  }
+
+  // Initiation interval of a channel or rule, from "interval" (cycles per message) or from
+  // "bytes_per_cycle" of the link and the message width. Returns 0 if neither is given.
+  inline unsigned int __annotate_interval(unsigned int interval, double bytes_per_cycle, unsigned int width)
+  {
+    if (interval > 0) { return interval; }
+    if (bytes_per_cycle > 0) {
+      interval = (unsigned int)std::ceil(((width + 7) / 8) / bytes_per_cycle);
+      return (interval > 0) ? interval : 1;
+    }
+    return 0;
+  }
+
+  inline void __annotate_read_bandwidth(const rapidjson::Value &v, unsigned int &interval, double &bytes_per_cycle)
+  {
+    interval = 0;
+    bytes_per_cycle = 0;
+    rapidjson::Value::ConstMemberIterator m = v.FindMember("interval");
+    if (m != v.MemberEnd()) {
+      assert(m->value.IsInt() && m->value.GetInt() > 0);
+      interval = m->value.GetInt();
+    }
+    m = v.FindMember("bytes_per_cycle");
+    if (m != v.MemberEnd()) {
+      assert(m->value.IsNumber() && m->value.GetDouble() > 0);
+      bytes_per_cycle = m->value.GetDouble();
+    }
+  }
+
+  inline unsigned int __annotate_interval(const rapidjson::Value &v, unsigned int width)
+  {
+    unsigned int interval;
+    double bytes_per_cycle;
+    __annotate_read_bandwidth(v, interval, bytes_per_cycle);
+    return __annotate_interval(interval, bytes_per_cycle, width);
+  }
+
+  // A pattern rule from the "rules" array of the input JSON, compiled once. A rule has either a
+  // glob "pattern" or a "regex", matched against the full channel name relative to root_name.
+  struct __annotate_rule {
+    std::string pattern;
+    channel_name_pattern name_pattern;
+    int latency, capacity;
+    unsigned int interval;      // 0 if not given
+    double bytes_per_cycle;     // 0 if not given
+
+    bool match(const std::string &name) const { return name_pattern.match(name); }
+  };
+
+  // Compile the "rules" array of the input JSON, if present. Rules are listed in order of
+  // precedence, the first matching rule applies.
+  inline void __annotate_compile_rules(rapidjson::Document &d, std::vector<__annotate_rule> &rules)
+  {
+    rules.clear();
+    if (! d.IsObject()) { return; }
+    rapidjson::Value::MemberIterator m_rules = d.FindMember("rules");
+    if (m_rules == d.MemberEnd() || ! m_rules->value.IsArray()) { return; }
+
+    for (rapidjson::Value::ValueIterator r = m_rules->value.Begin(); r != m_rules->value.End(); ++r) {
+      rapidjson::Value::MemberIterator m_pattern = r->FindMember("pattern");
+      rapidjson::Value::MemberIterator m_regex = r->FindMember("regex");
+      rapidjson::Value::MemberIterator m_latency = r->FindMember("latency");
+      rapidjson::Value::MemberIterator m_capacity = r->FindMember("capacity");
+      if (m_latency == r->MemberEnd() || m_capacity == r->MemberEnd() ||
+          (m_pattern == r->MemberEnd()) == (m_regex == r->MemberEnd())) {
+        cout << "Error: During annotation each rule needs latency, capacity and one of pattern or regex" << endl;
+        assert(0);
+        continue;
+      }
+      assert(m_latency->value.IsInt() && m_capacity->value.IsInt());
+
+      __annotate_rule rule;
+      rule.latency = m_latency->value.GetInt();
+      rule.capacity = m_capacity->value.GetInt();
+      __annotate_read_bandwidth(*r, rule.interval, rule.bytes_per_cycle);
+      bool is_regex = (m_regex != r->MemberEnd());
+      rule.pattern = is_regex ? m_regex->value.GetString() : m_pattern->value.GetString();
+      rule.name_pattern.assign(rule.pattern, is_regex);
+      rules.push_back(rule);
+    }
+  }
+
+  inline const __annotate_rule *__annotate_match_rule(const std::vector<__annotate_rule> &rules, const std::string &name)
+  {
+    for (std::size_t i = 0; i < rules.size(); i++) {
+      if (rules[i].match(name)) { return &rules[i]; }
+    }
+    return 0;
+  }
 
   void __annotate_vector(std::vector<Connections::Connections_BA_abs *> &v, const std::string &root_name, rapidjson::Document &d)
   {
+    std::vector<__annotate_rule> rules;
+    __annotate_compile_rules(d, rules);
+
     // Check if array exists, if not add it.
     if (! d.HasMember("channels")) {
       rapidjson::Value v_channels;
@@ -54,65 +205,66 @@ namespace Connections
     }
     rapidjson::Value &v_channels = d["channels"];
 
+    // RapidJSON member lookup is a linear scan, so index the channels once by name.
+    // Channels are only ever appended, so member indices stay valid as the DOM grows.
+    typedef std::unordered_map<std::string, rapidjson::SizeType> channel_index_t;
+    channel_index_t channel_index;
+    channel_index.reserve(v_channels.MemberCount() + v.size());
+    for (rapidjson::Value::MemberIterator m = v_channels.MemberBegin(); m != v_channels.MemberEnd(); ++m) {
+      channel_index.insert(std::make_pair(std::string(m->name.GetString(), m->name.GetStringLength()),
+                                          static_cast<rapidjson::SizeType>(m - v_channels.MemberBegin())));
+    }
+
     // Annotate
+    std::string it_name;
     for ( std::vector<Connections::Connections_BA_abs *>::iterator it=v.begin(); it!=v.end(); ++it ) {
       // Determine name after removing root_name
-      std::string it_name = (*it)->name();
-      std::size_t pos = it_name.find(root_name);
-      if (pos == std::string::npos) { continue; } // Skip if doesn't match root_name
-      it_name.erase(pos, root_name.length());
+      if (! __annotate_channel_name((*it)->name(), root_name, it_name)) { continue; } // Skip if doesn't match root_name
 
       // Check if this channel exists in DOM, if not add it.
-      if (! v_channels.HasMember(it_name.c_str())) {
+      channel_index_t::iterator ci = channel_index.find(it_name);
+      if (ci == channel_index.end()) {
         rapidjson::Value v_name;
         v_name.SetString(it_name.c_str(), d.GetAllocator());
         rapidjson::Value v_channel;
         v_channel.SetObject();
         v_channels.AddMember(v_name, v_channel, d.GetAllocator());
+        ci = channel_index.insert(std::make_pair(it_name, v_channels.MemberCount() - 1)).first;
       }
-      rapidjson::Value &v_channel = v_channels[it_name.c_str()];
-
-      // Check if latency exists, if not add it
-      if (! v_channel.HasMember("latency")) {
-        rapidjson::Value v_latency;
-        v_latency.SetInt(0);
-        v_channel.AddMember("latency", v_latency, d.GetAllocator());
+      rapidjson::Value &v_channel = (v_channels.MemberBegin() + ci->second)->value;
+
+      // Check if latency and capacity exist, if not add them, resolved from the first matching
+      // rule. Explicit channel entries take precedence over rules.
+      const __annotate_rule *rule = 0;
+      if (! rules.empty() && (! v_channel.HasMember("latency") || ! v_channel.HasMember("capacity"))) {
+        rule = __annotate_match_rule(rules, it_name);
+        if (rule && ! v_channel.HasMember("rule")) {
+          rapidjson::Value v_rule;
+          v_rule.SetString(rule->pattern.c_str(), d.GetAllocator());
+          v_channel.AddMember("rule", v_rule, d.GetAllocator());
+        }
       }
-      rapidjson::Value &v_latency = v_channel["latency"];
-
-      // Check if capacity exists, if not add it
-      if (! v_channel.HasMember("capacity")) {
-        rapidjson::Value v_capacity;
-        v_capacity.SetInt(0);
-        v_channel.AddMember("capacity", v_capacity, d.GetAllocator());
+      int latency = __annotate_int_member(v_channel, "latency", rule ? rule->latency : 0, d);
+      int capacity = __annotate_int_member(v_channel, "capacity", rule ? rule->capacity : 0, d);
+
+      // Optional initiation interval, recorded in cycles per message.
+      unsigned int interval = __annotate_interval(v_channel, (*it)->message_width());
+      if (interval == 0 && rule) { interval = __annotate_interval(rule->interval, rule->bytes_per_cycle, (*it)->message_width()); }
+      if (interval > 1 && ! v_channel.HasMember("interval")) {
+        rapidjson::Value v_int;
+        v_int.SetInt(interval);
+        v_channel.AddMember("interval", v_int, d.GetAllocator());
       }
-      rapidjson::Value &v_capacity = v_channel["capacity"];
 
       // Get the src_name and dest_name after subtracting off root
-      std::string src_name = (*it)->src_name();
-      {
-        if (src_name.substr(src_name.length() - 4,4) == "_" _VLDNAMESTR_) { src_name.erase(src_name.length() - 4,4); }
-        std::size_t pos = src_name.find(root_name);
-        if (pos != std::string::npos) { src_name.erase(pos, root_name.length()); }
-#ifdef MTI_SYSTEMC
-        for (size_t i=0; i<src_name.length(); i++) { if (src_name[i]=='/') { src_name[i]='.'; } }
-#endif
-      }
-
-      std::string dest_name = (*it)->dest_name();
-      {
-        if (dest_name.substr(dest_name.length() - 4,4) == "_" _VLDNAMESTR_) { dest_name.erase(dest_name.length() - 4,4); }
-        std::size_t pos = dest_name.find(root_name);
-        if (pos != std::string::npos) { dest_name.erase(pos, root_name.length()); }
-#ifdef MTI_SYSTEMC
-        for (size_t i=0; i<dest_name.length(); i++) { if (dest_name[i]=='/') { dest_name[i]='.'; } }
-#endif
-      }
+      std::string src_name = __annotate_port_name((*it)->src_name(), root_name);
+      std::string dest_name = __annotate_port_name((*it)->dest_name(), root_name);
 
       // Add the net driver/receiver, always an output never an input.
-      if (v_channel.HasMember("src_name")) {
-        if (strcmp(v_channel["src_name"].GetString(),src_name.c_str()) != 0) {
-          cout << "Error: During annotation src_name in input doesn't match real src_name (" << v_channel["src_name"].GetString() << " != " << src_name.c_str() << ")" << endl;
+      rapidjson::Value::MemberIterator m_src_name = v_channel.FindMember("src_name");
+      if (m_src_name != v_channel.MemberEnd()) {
+        if (strcmp(m_src_name->value.GetString(),src_name.c_str()) != 0) {
+          cout << "Error: During annotation src_name in input doesn't match real src_name (" << m_src_name->value.GetString() << " != " << src_name.c_str() << ")" << endl;
           return;
           //assert(0);
         }
@@ -122,9 +274,10 @@ namespace Connections
         v_channel.AddMember("src_name", v_src_name, d.GetAllocator());
       }
 
-      if (v_channel.HasMember("dest_name")) {
-        if (strcmp(v_channel["dest_name"].GetString(),dest_name.c_str()) != 0) {
-          cout << "Error: During annotation dest_name in input doesn't match real dest_name (" << v_channel["dest_name"].GetString() << " != " << dest_name.c_str() << ")" << endl;
+      rapidjson::Value::MemberIterator m_dest_name = v_channel.FindMember("dest_name");
+      if (m_dest_name != v_channel.MemberEnd()) {
+        if (strcmp(m_dest_name->value.GetString(),dest_name.c_str()) != 0) {
+          cout << "Error: During annotation dest_name in input doesn't match real dest_name (" << m_dest_name->value.GetString() << " != " << dest_name.c_str() << ")" << endl;
           assert(0);
         }
       } else {
@@ -134,9 +287,148 @@ namespace Connections
       }
 
       // Annotate based on the value.
-      assert(v_latency.IsInt());
-      assert(v_capacity.IsInt());
-      (*it)->annotate(v_latency.GetInt(), v_capacity.GetInt());
+      if (interval > 1) {
+        (*it)->annotate(latency, capacity, interval);
+      } else {
+        (*it)->annotate(latency, capacity);
+      }
+    }
+  }
+
+  // Joins a deferred output.json write, at the latest on exit.
+  struct __annotate_output_thread {
+    std::thread t;
+    void join() { if (t.joinable()) { t.join(); } }
+    ~__annotate_output_thread() { join(); }
+  };
+
+  // See: https://stackoverflow.com/questions/18860895/how-to-initialize-static-members-in-the-header
+  template <class Dummy>
+  struct __annotate_statics {
+    static unsigned int output_flags;
+    static __annotate_output_thread output_thread;
+  };
+
+  template <class Dummy>
+  unsigned int __annotate_statics<Dummy>::output_flags = ANNOTATE_OUTPUT_PRETTY;
+  template <class Dummy>
+  __annotate_output_thread __annotate_statics<Dummy>::output_thread;
+
+  // A channel is worth writing with ANNOTATE_OUTPUT_ANNOTATED_ONLY if it was listed in the
+  // input, i.e. its index is below n_input_channels, or if it ended up annotated.
+  inline bool __annotate_keep_channel(const rapidjson::Value &v_channel, rapidjson::SizeType index, rapidjson::SizeType n_input_channels)
+  {
+    if (index < n_input_channels) { return true; }
+    if (! v_channel.IsObject()) { return true; }
+    rapidjson::Value::ConstMemberIterator m = v_channel.FindMember("latency");
+    if (m != v_channel.MemberEnd() && ! (m->value.IsInt() && m->value.GetInt() == 0)) { return true; }
+    m = v_channel.FindMember("capacity");
+    if (m != v_channel.MemberEnd() && ! (m->value.IsInt() && m->value.GetInt() == 0)) { return true; }
+    return v_channel.HasMember("rule") || v_channel.HasMember("interval");
+  }
+
+  template <typename Writer>
+  void __annotate_write(const rapidjson::Document &d, Writer &writer, bool annotated_only, rapidjson::SizeType n_input_channels)
+  {
+    if (! annotated_only || ! d.IsObject()) {
+      d.Accept(writer);
+      return;
+    }
+    writer.StartObject();
+    for (rapidjson::Value::ConstMemberIterator m = d.MemberBegin(); m != d.MemberEnd(); ++m) {
+      writer.Key(m->name.GetString(), m->name.GetStringLength());
+      if (strcmp(m->name.GetString(), "channels") != 0 || ! m->value.IsObject()) {
+        m->value.Accept(writer);
+        continue;
+      }
+      writer.StartObject();
+      for (rapidjson::Value::ConstMemberIterator c = m->value.MemberBegin(); c != m->value.MemberEnd(); ++c) {
+        if (! __annotate_keep_channel(c->value, static_cast<rapidjson::SizeType>(c - m->value.MemberBegin()), n_input_channels)) { continue; }
+        writer.Key(c->name.GetString(), c->name.GetStringLength());
+        c->value.Accept(writer);
+      }
+      writer.EndObject();
+    }
+    writer.EndObject();
+  }
+
+  inline void __annotate_write_file(std::shared_ptr<rapidjson::Document> d, std::string output_path, unsigned int flags,
+                                    rapidjson::SizeType n_input_channels)
+  {
+    FILE *fp = fopen(output_path.c_str(), "w");
+    if (! fp) {
+      cerr << "Warning: Could not write output json " << output_path << endl;
+      return;
+    }
+    char buf[65536];
+    rapidjson::FileWriteStream os(fp, buf, sizeof(buf));
+    bool annotated_only = (flags & ANNOTATE_OUTPUT_ANNOTATED_ONLY) != 0;
+    if (flags & ANNOTATE_OUTPUT_COMPACT) {
+      rapidjson::Writer<rapidjson::FileWriteStream> writer(os);
+      __annotate_write(*d, writer, annotated_only, n_input_channels);
+    } else {
+      rapidjson::PrettyWriter<rapidjson::FileWriteStream> writer(os);
+      __annotate_write(*d, writer, annotated_only, n_input_channels);
+    }
+    os.Flush();
+    fclose(fp);
+  }
+
+  inline void set_annotate_output(unsigned int flags)
+  {
+    __annotate_statics<void>::output_flags = flags;
+  }
+
+  inline void wait_annotate_output()
+  {
+    __annotate_statics<void>::output_thread.join();
+  }
+
+  // Annotate from input_path and write output_path, see annotate_design(). A missing input
+  // is an error if explicit_input is set.
+  void __annotate_design_paths(const sc_object &root, const std::string &input_path, bool explicit_input,
+                               const std::string &output_path, unsigned int flags)
+  {
+    // Create DOM object, shared with a deferred output writer.
+    std::shared_ptr<rapidjson::Document> dp(new rapidjson::Document);
+    rapidjson::Document &d = *dp;
+
+    // Try reading document from input.json
+    std::ifstream ifs(input_path.c_str());
+    if (! ifs.fail()) {
+      CONNECTIONS_COUT("Info: Reading back-annotation from " << input_path << ". Please check " << input_path << " and " << output_path << " to ensure it matches expectations." << endl);
+      rapidjson::IStreamWrapper isw(ifs);
+      d.ParseStream(isw);
+    } else {
+      if (explicit_input) {
+        CONNECTIONS_ASSERT_MSG(0, ("Warning: Could not read input json " + input_path).c_str());
+      } else {
+        CONNECTIONS_COUT("Warning: Could not read input json " << input_path.c_str() << endl);
+      }
+      d.SetObject();
+    }
+
+    std::string root_name = std::string(root.name());
+    assert(!root_name.empty());
+#ifdef MTI_SYSTEMC
+    root_name += "/";
+#else
+    root_name += ".";
+#endif
+
+    // Channels listed in input.json come first in the DOM, new ones are appended after them.
+    rapidjson::SizeType n_input_channels = 0;
+    if (d.IsObject() && d.HasMember("channels") && d["channels"].IsObject()) { n_input_channels = d["channels"].MemberCount(); }
+
+    __annotate_vector(Connections::get_conManager().tracked_annotate, root_name, d);
+
+    // Output DOM to file
+    if (flags & ANNOTATE_OUTPUT_NONE) { return; }
+    wait_annotate_output(); // One deferred write at a time.
+    if (flags & ANNOTATE_OUTPUT_DEFERRED) {
+      __annotate_statics<void>::output_thread.t = std::thread(__annotate_write_file, dp, output_path, flags, n_input_channels);
+    } else {
+      __annotate_write_file(dp, output_path, flags, n_input_channels);
     }
   }
 
@@ -167,23 +459,22 @@ namespace Connections
     std::string input_path  = input_dir_path + base_name + "input.json";
     std::string output_path = output_dir_path + base_name + "output.json";
 
-    // Create DOM object.
-    rapidjson::Document d;
+    __annotate_design_paths(root, input_path, explicit_input_dir, output_path, __annotate_statics<void>::output_flags);
+  }
 
-    // Try reading document from input.json
+  void reannotate_design(const sc_object &root, std::string input_path, unsigned long delay_cycles = 0)
+  {
+    // Read the new annotation.
+    rapidjson::Document d;
     std::ifstream ifs(input_path.c_str());
-    if (! ifs.fail()) {
-      CONNECTIONS_COUT("Info: Reading back-annotation from " << input_path << ". Please check " << input_path << " and " << output_path << " to ensure it matches expectations." << endl);
-      rapidjson::IStreamWrapper isw(ifs);
-      d.ParseStream(isw);
-    } else {
-      if (explicit_input_dir) {
-        CONNECTIONS_ASSERT_MSG(0, ("Warning: Could not read input json " + input_path).c_str());
-      } else {
-        CONNECTIONS_COUT("Warning: Could not read input json " << input_path.c_str() << endl);
-      }
-      d.SetObject();
+    if (ifs.fail()) {
+      CONNECTIONS_ASSERT_MSG(0, ("Warning: Could not read input json " + input_path).c_str());
+      return;
     }
+    CONNECTIONS_COUT("Info: Re-annotating from " << input_path << " at " << sc_time_stamp() << endl);
+    rapidjson::IStreamWrapper isw(ifs);
+    d.ParseStream(isw);
+    if (! d.IsObject()) { return; }
 
     std::string root_name = std::string(root.name());
     assert(!root_name.empty());
@@ -193,13 +484,46 @@ namespace Connections
     root_name += ".";
 #endif
 
-    __annotate_vector(Connections::get_conManager().tracked_annotate, root_name, d);
+    // Index the channels below root by name, then walk the (usually much shorter) input.
+    std::vector<Connections::Connections_BA_abs *> &v = Connections::get_conManager().tracked_annotate;
+    std::unordered_map<std::string, Connections::Connections_BA_abs *> channel_index;
+    channel_index.reserve(v.size());
+    std::string it_name;
+    for ( std::vector<Connections::Connections_BA_abs *>::iterator it=v.begin(); it!=v.end(); ++it ) {
+      if (__annotate_channel_name((*it)->name(), root_name, it_name)) { channel_index[it_name] = *it; }
+    }
 
-    // Output DOM to file
-    std::ofstream ofs(output_path.c_str());
-    rapidjson::OStreamWrapper osw(ofs);
-    rapidjson::PrettyWriter<rapidjson::OStreamWrapper> writer(osw);
-    d.Accept(writer);
+    rapidjson::Value::MemberIterator m_channels = d.FindMember("channels");
+    if (m_channels != d.MemberEnd()) {
+      rapidjson::Value &v_channels = m_channels->value;
+      for (rapidjson::Value::MemberIterator m = v_channels.MemberBegin(); m != v_channels.MemberEnd(); ++m) {
+        std::unordered_map<std::string, Connections::Connections_BA_abs *>::iterator ci =
+          channel_index.find(std::string(m->name.GetString(), m->name.GetStringLength()));
+        if (ci == channel_index.end()) {
+          cout << "Warning: During re-annotation channel " << m->name.GetString() << " not found in design" << endl;
+          continue;
+        }
+        rapidjson::Value::MemberIterator m_latency = m->value.FindMember("latency");
+        rapidjson::Value::MemberIterator m_capacity = m->value.FindMember("capacity");
+        if (m_latency == m->value.MemberEnd() || m_capacity == m->value.MemberEnd()) { continue; }
+        assert(m_latency->value.IsInt() && m_capacity->value.IsInt());
+        unsigned int interval = __annotate_interval(m->value, ci->second->message_width());
+        ci->second->reannotate(m_latency->value.GetInt(), m_capacity->value.GetInt(), delay_cycles, interval > 0 ? interval : 1);
+        channel_index.erase(ci); // Explicit entries take precedence over rules.
+      }
+    }
+
+    // Remaining channels take the first matching rule, if any.
+    std::vector<__annotate_rule> rules;
+    __annotate_compile_rules(d, rules);
+    if (rules.empty()) { return; }
+    for (std::unordered_map<std::string, Connections::Connections_BA_abs *>::iterator ci = channel_index.begin(); ci != channel_index.end(); ++ci) {
+      const __annotate_rule *rule = __annotate_match_rule(rules, ci->first);
+      if (rule) {
+        unsigned int interval = __annotate_interval(rule->interval, rule->bytes_per_cycle, ci->second->message_width());
+        ci->second->reannotate(rule->latency, rule->capacity, delay_cycles, interval > 0 ? interval : 1);
+      }
+    }
   }
 
 #else
@@ -222,16 +546,40 @@ namespace Connections
    *      the channel. For a retimed path, latency and capacity should be equal, while for
    *      buffered paths capacity will exceed latency.
    *
-   *      Back annotation will only work with CONNECTIONS_ACCURATE_SIM define enabled, and
-   *      in MARSHALL_PORT or DIRECT_PORT modes. It will not work in TLM_PORT (CONNECTIONS_FAST_SIM)
-   *      or SYN_PORT modes. Additionally, it is dependent on RapidJSON as a git submodule to read
-   *      and write JSON file format.
+   *      A channel may also be given an "interval", the minimum number of cycles between two
+   *      messages it accepts, to model serialized links. Alternatively "bytes_per_cycle" gives
+   *      the link bandwidth, and the interval is derived from the message width. An interval
+   *      above 1 requires a nonzero latency. The resolved interval is written to
+   *      base_name.output.json. Fifo instances don't support interval annotation.
+   *
+   *      In CONNECTIONS_ACCURATE_SIM, Fifo instances are annotated as well, under the name
+   *      <fifo>.fifo_BA. For a Fifo, latency is the number of cycles from enqueue until an entry
+   *      can be dequeued (values of 0 and 1 both leave the Fifo unchanged), and a nonzero capacity
+   *      limits the number of entries in use, up to the Fifo depth.
+   *
+   *      Back annotation works in MARSHALL_PORT and DIRECT_PORT modes (CONNECTIONS_ACCURATE_SIM),
+   *      where it is cycle accurate, and in TLM_PORT mode (CONNECTIONS_FAST_SIM). In TLM_PORT mode
+   *      the channel's tlm_fifo becomes a delay line: each message can be read latency clock
+   *      periods after it was written, and capacity sets the fifo size. This approximates the
+   *      accurate model and uses the same JSON files. It does not work in SYN_PORT mode.
+   *      Additionally, it is dependent on RapidJSON as a git submodule to read and write JSON
+   *      file format.
    *
    *      In the base_name.output.json, a list of combinational names and connecting ports is given.
    *      UNBOUND indicates a Combinational channel that hasn't been Bind()'d on one or more ports,
    *      while TLM_INTERFACE indicates a channel that is along a TLM_PORT interface in cosimulation
    *      cases.
    *
+   *      For large designs, set_annotate_output() can make base_name.output.json compact, limit
+   *      it to annotated channels, move the write to a background thread, or skip it.
+   *
+   *      Instead of listing every channel, base_name.input.json may hold a "rules" array. Each rule
+   *      gives a latency and capacity for all channels whose name (relative to root) matches its
+   *      glob "pattern" ('*' and '?' wildcards) or its ECMAScript "regex". Rules are tried in order
+   *      and the first match applies, while an explicit entry under "channels" always takes
+   *      precedence. Channels annotated by a rule are written to base_name.output.json with the
+   *      resolved latency and capacity, and the matching rule.
+   *
    * \par A Simple Example
    * \code
    *      #include <connections/connections.h>
@@ -246,13 +594,113 @@ namespace Connections
    * \endcode
    * \par
    *
+   * \par Example of Rules in base_name.input.json
+   * \code
+   *      {
+   *        "rules": [
+   *          { "pattern": "*.noc.*_link", "latency": 3, "capacity": 4, "bytes_per_cycle": 16 },
+   *          { "regex": "cpu[0-9]+\\.l2_.*", "latency": 1, "capacity": 2 }
+   *        ],
+   *        "channels": {
+   *          "noc.ctrl_link": { "latency": 1, "capacity": 1 }
+   *        }
+   *      }
+   * \endcode
+   * \par
+   *
    */
   void annotate_design(const sc_object &root, std::string base_name = "", std::string input_dir_path = "", std::string output_dir_path = "")
   {
-    cerr << "WARNING: Cannot annotate_design() unless running in sim accurate mode!" << endl;
+    cerr << "WARNING: Cannot annotate_design() unless running in simulation (CONNECTIONS_ACCURATE_SIM or CONNECTIONS_FAST_SIM)!" << endl;
     cerr << "WARNING: Design will not be annotated." << endl;
   }
 
+  /**
+   * \brief Select how annotate_design() writes base_name.output.json
+   * \ingroup Connections
+   *
+   * \tparam flags         Or'ed annotate_output_flags (defaults to ANNOTATE_OUTPUT_PRETTY).
+   *
+   * \par Description
+   *      ANNOTATE_OUTPUT_COMPACT writes the JSON without whitespace. ANNOTATE_OUTPUT_ANNOTATED_ONLY
+   *      leaves out channels that are neither listed in base_name.input.json nor annotated (by a
+   *      rule, or a nonzero latency, capacity or interval), which keeps the file small when most
+   *      channels are plain wires. ANNOTATE_OUTPUT_DEFERRED writes the file from a background
+   *      thread so annotate_design() returns without waiting for it; use wait_annotate_output()
+   *      before reading the file, the write is also joined on exit. ANNOTATE_OUTPUT_NONE skips
+   *      the file altogether. Must be called before annotate_design().
+   *
+   * \par A Simple Example
+   * \code
+   *      #include <connections/connections.h>
+   *      #include <connections/annotate.h>
+   *
+   *      ...
+   *      Connections::set_annotate_output(Connections::ANNOTATE_OUTPUT_COMPACT |
+   *                                       Connections::ANNOTATE_OUTPUT_ANNOTATED_ONLY |
+   *                                       Connections::ANNOTATE_OUTPUT_DEFERRED);
+   *      annotate_design(my_testbench.dut);
+   *      sc_start();
+   *      ...
+   * \endcode
+   * \par
+   *
+   */
+  inline void set_annotate_output(unsigned int flags)
+  {
+  }
+
+  /**
+   * \brief Wait for a deferred base_name.output.json write to complete
+   * \ingroup Connections
+   *
+   * \par Description
+   *      Returns once the file written by the last annotate_design() with
+   *      ANNOTATE_OUTPUT_DEFERRED set is complete. Returns right away otherwise.
+   *
+   */
+  inline void wait_annotate_output()
+  {
+  }
+
+  /**
+   * \brief Change the back annotation of a design during simulation
+   * \ingroup Connections
+   *
+   * \tparam root          Root sc_object to re-annotate.
+   * \tparam input_path    Path of a JSON file in the base_name.input.json format.
+   * \tparam delay_cycles  Clock cycles from now until the new values apply (optional, defaults to 0).
+   *
+   * \par Description
+   *      Applies the latency and capacity of every channel listed in input_path, or matched by
+   *      one of its rules, to an already annotated design without re-elaborating it. Channels
+   *      missing from the file keep their current annotation, and no output.json is written.
+   *
+   *      Each channel switches at its first clock edge delay_cycles from now at which the
+   *      messages it holds fit the new capacity. Until then its input is stalled so that it
+   *      drains, messages in flight keep their original ready cycle. Switching to a latency of 0
+   *      additionally requires the channel to be empty. Called before sc_start(), the new values
+   *      apply immediately.
+   *
+   * \par A Simple Example
+   * \code
+   *      #include <connections/connections.h>
+   *      #include <connections/annotate.h>
+   *
+   *      ...
+   *      // In a testbench thread, switch the DUT to a new annotation 100 cycles from now.
+   *      reannotate_design(dut, "dut.phase2.input.json", 100);
+   *      ...
+   * \endcode
+   * \par
+   *
+   */
+  void reannotate_design(const sc_object &root, std::string input_path, unsigned long delay_cycles = 0)
+  {
+    cerr << "WARNING: Cannot reannotate_design() unless running in simulation (CONNECTIONS_ACCURATE_SIM or CONNECTIONS_FAST_SIM)!" << endl;
+    cerr << "WARNING: Design will not be re-annotated." << endl;
+  }
+
 #endif
 };
 
@@ -0,0 +1,371 @@
+/**************************************************************************
+ *                                                                        *
+ *  HLS Connections Library                                               *
+ *                                                                        *
+ *  Software Version: 2026.2                                              *
+ *                                                                        *
+ *  Release Date    : Tue May 12 21:38:26 PDT 2026                        *
+ *  Release Type    : Production Release                                  *
+ *  Release Build   : 2026.2.0                                            *
+ *                                                                        *
+ *  Copyright 2026 Siemens                                                *
+ *                                                                        *
+ **************************************************************************
+ *  Licensed under the Apache License, Version 2.0 (the "License");       *
+ *  you may not use this file except in compliance with the License.      * 
+ *  You may obtain a copy of the License at                               *
+ *                                                                        *
+ *      http://www.apache.org/licenses/LICENSE-2.0                        *
+ *                                                                        *
+ *  Unless required by applicable law or agreed to in writing, software   * 
+ *  distributed under the License is distributed on an "AS IS" BASIS,     * 
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or       *
+ *  implied.                                                              * 
+ *  See the License for the specific language governing permissions and   * 
+ *  limitations under the License.                                        *
+ **************************************************************************
+ *                                                                        *
+ *  The most recent version of this package is available at github.       *
+ *                                                                        *
+ *************************************************************************/
+
+//*****************************************************************************************
+// annotate_sweep.h
+//
+// Runs one elaborated design under many back-annotation input JSON files, forking a
+// worker process per file after elaboration.
+//
+//*****************************************************************************************
+
+
+#ifndef __CONNECTIONS__ANNOTATE_SWEEP_H__
+#define __CONNECTIONS__ANNOTATE_SWEEP_H__
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <sstream>
+#include <ostream>
+#include <cstdio>
+#include <cstdlib>
+
+#include "annotate.h"
+
+#if defined(CONNECTIONS_SIM_ONLY) && !defined(_WIN32)
+#define CONNECTIONS_ANNOTATE_SWEEP
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace Connections
+{
+
+  // Result of one annotate_sweep() worker.
+  struct annotate_sweep_result {
+    std::string input_path;
+    int status;               // 0 on success, else the worker's exit status, or -signal if it was killed
+    double sim_time_ns;       // sc_time_stamp() when sc_start() returned
+    unsigned long cycles;     // sim_time_ns in periods of the first clock
+    std::vector<std::pair<std::string, double> > metrics; // from the collect callback
+
+    annotate_sweep_result() : status(-1), sim_time_ns(0), cycles(0) {}
+  };
+
+  // Called in each worker after sc_start() returns, to add design specific metrics such as
+  // transactions per cycle.
+  typedef std::function<void(std::vector<std::pair<std::string, double> > &)> annotate_sweep_collect_t;
+
+  /**
+   * \brief Write annotate_sweep() results as CSV
+   * \ingroup Connections
+   *
+   * \par Description
+   *      One row per input file, with the columns input, status, sim_time_ns, cycles and then
+   *      every metric name reported by any worker, in order of first appearance. Metrics a
+   *      worker didn't report are left empty.
+   *
+   */
+  inline void write_annotate_sweep_csv(const std::vector<annotate_sweep_result> &results, std::ostream &os)
+  {
+    std::vector<std::string> names;
+    for (unsigned i = 0; i < results.size(); i++) {
+      for (unsigned j = 0; j < results[i].metrics.size(); j++) {
+        const std::string &n = results[i].metrics[j].first;
+        unsigned k = 0;
+        while (k < names.size() && names[k] != n) { k++; }
+        if (k == names.size()) { names.push_back(n); }
+      }
+    }
+
+    os << "input,status,sim_time_ns,cycles";
+    for (unsigned k = 0; k < names.size(); k++) { os << ",\"" << names[k] << "\""; }
+    os << "\n";
+    for (unsigned i = 0; i < results.size(); i++) {
+      const annotate_sweep_result &r = results[i];
+      os << "\"" << r.input_path << "\"," << r.status << "," << r.sim_time_ns << "," << r.cycles;
+      for (unsigned k = 0; k < names.size(); k++) {
+        os << ",";
+        for (unsigned j = 0; j < r.metrics.size(); j++) {
+          if (r.metrics[j].first == names[k]) { os << r.metrics[j].second; break; }
+        }
+      }
+      os << "\n";
+    }
+  }
+
+#ifdef CONNECTIONS_ANNOTATE_SWEEP
+
+  // Worker side: annotate, simulate, report the result on fd as "key\tvalue" lines, and exit
+  // without running the design's destructors. Binary channel logs, closed before the fork,
+  // are reopened on a file per worker, e.g. channel_logs_data_<n>.bin.
+  inline void __annotate_sweep_worker(const sc_object &root, const std::string &input_path, const sc_time &duration,
+                                      const annotate_sweep_collect_t &collect, int fd, std::size_t n)
+  {
+    std::ostringstream suffix;
+    suffix << "_" << n;
+    channel_log_binary::reopen_closed(suffix.str());
+
+    int log = open((input_path + ".log").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (log >= 0) {
+      dup2(log, 1);
+      dup2(log, 2);
+      close(log);
+    }
+
+    __annotate_design_paths(root, input_path, true, "", ANNOTATE_OUTPUT_NONE);
+
+    if (duration > SC_ZERO_TIME) {
+      sc_start(duration);
+    } else {
+      sc_start();
+    }
+    channel_log_binary::close_all();
+
+    std::ostringstream ss;
+    ss.precision(17);
+    ss << "sim_time_ns\t" << sc_time_stamp().to_seconds() * 1e9 << "\n";
+    if (! get_sim_clk().clk_info_vector.empty()) {
+      sc_time period = get_sim_clk().clk_info_vector[0].clk_ptr->period();
+      ss << "cycles\t" << (unsigned long)(sc_time_stamp() / period) << "\n";
+    }
+    if (collect) {
+      std::vector<std::pair<std::string, double> > metrics;
+      collect(metrics);
+      for (unsigned i = 0; i < metrics.size(); i++) {
+        ss << "metric\t" << metrics[i].first << "\t" << metrics[i].second << "\n";
+      }
+    }
+
+    std::string out = ss.str();
+    const char *p = out.c_str();
+    std::size_t left = out.length();
+    while (left > 0) {
+      ssize_t n = write(fd, p, left);
+      if (n < 0 && errno == EINTR) { continue; }
+      if (n <= 0) { break; }
+      p += n;
+      left -= n;
+    }
+    close(fd);
+    std::cout.flush();
+    fflush(stdout);
+    _exit(0);
+  }
+
+  inline void __annotate_sweep_parse(const std::string &text, annotate_sweep_result &r)
+  {
+    std::istringstream is(text);
+    std::string line;
+    while (std::getline(is, line)) {
+      std::size_t tab = line.find('\t');
+      if (tab == std::string::npos) { continue; }
+      std::string key = line.substr(0, tab);
+      std::string val = line.substr(tab + 1);
+      if (key == "sim_time_ns") {
+        r.sim_time_ns = strtod(val.c_str(), 0);
+      } else if (key == "cycles") {
+        r.cycles = strtoul(val.c_str(), 0, 10);
+      } else if (key == "metric") {
+        std::size_t tab2 = val.rfind('\t');
+        if (tab2 == std::string::npos) { continue; }
+        r.metrics.push_back(std::make_pair(val.substr(0, tab2), strtod(val.c_str() + tab2 + 1, 0)));
+      }
+    }
+  }
+
+  std::vector<annotate_sweep_result> annotate_sweep(const sc_object &root, const std::vector<std::string> &input_paths,
+                                                    const sc_time &duration = SC_ZERO_TIME, unsigned int max_jobs = 0,
+                                                    annotate_sweep_collect_t collect = annotate_sweep_collect_t())
+  {
+    CONNECTIONS_ASSERT_MSG(sc_get_status() & (SC_ELABORATION | SC_BEFORE_END_OF_ELABORATION),
+                           "annotate_sweep() must be called after elaboration and before sc_start()");
+
+    std::vector<annotate_sweep_result> results(input_paths.size());
+    for (unsigned i = 0; i < input_paths.size(); i++) { results[i].input_path = input_paths[i]; }
+
+    if (max_jobs == 0) {
+      long n = sysconf(_SC_NPROCESSORS_ONLN);
+      max_jobs = (n > 0) ? (unsigned int)n : 1;
+    }
+
+    // Workers inherit the parent's buffers, flush them so nothing is printed twice. Stop the
+    // writer threads of binary channel logs too, fork() is only safe in a single threaded
+    // process; each worker reopens the logs on its own file.
+    wait_annotate_output();
+    channel_log_binary::close_for_fork();
+    std::cout.flush();
+    std::cerr.flush();
+    fflush(0);
+
+    struct job {
+      pid_t pid;
+      int fd;
+      std::size_t index;
+      std::string out;
+    };
+    std::vector<job> running;
+    std::size_t next = 0;
+
+    while (next < input_paths.size() || ! running.empty()) {
+      // Start workers up to max_jobs.
+      while (next < input_paths.size() && running.size() < max_jobs) {
+        int fds[2];
+        if (pipe(fds) != 0) {
+          cerr << "Warning: annotate_sweep() could not create a pipe for " << input_paths[next] << endl;
+          next++;
+          continue;
+        }
+        pid_t pid = fork();
+        if (pid == 0) {
+          close(fds[0]);
+          __annotate_sweep_worker(root, input_paths[next], duration, collect, fds[1], next);
+        }
+        close(fds[1]);
+        if (pid < 0) {
+          cerr << "Warning: annotate_sweep() could not fork a worker for " << input_paths[next] << endl;
+          close(fds[0]);
+          next++;
+          continue;
+        }
+        job j;
+        j.pid = pid;
+        j.fd = fds[0];
+        j.index = next++;
+        running.push_back(j);
+      }
+      if (running.empty()) { continue; }
+
+      // Collect worker output, reaping each worker once its pipe is closed.
+      std::vector<pollfd> pfds(running.size());
+      for (unsigned i = 0; i < running.size(); i++) {
+        pfds[i].fd = running[i].fd;
+        pfds[i].events = POLLIN;
+        pfds[i].revents = 0;
+      }
+      if (poll(&pfds[0], pfds.size(), -1) < 0) {
+        if (errno == EINTR) { continue; }
+        perror("annotate_sweep: poll");
+        // Stop the remaining workers, their results stay at status -1.
+        for (unsigned i = 0; i < running.size(); i++) {
+          kill(running[i].pid, SIGKILL);
+          close(running[i].fd);
+          while (waitpid(running[i].pid, 0, 0) < 0 && errno == EINTR) {}
+        }
+        running.clear();
+        break;
+      }
+      for (int i = (int)running.size() - 1; i >= 0; i--) {
+        if (! pfds[i].revents) { continue; }
+        char buf[4096];
+        ssize_t n = read(running[i].fd, buf, sizeof(buf));
+        if (n > 0) {
+          running[i].out.append(buf, n);
+          continue;
+        }
+        if (n < 0 && errno == EINTR) { continue; }
+
+        close(running[i].fd);
+        int status = 0;
+        while (waitpid(running[i].pid, &status, 0) < 0 && errno == EINTR) {}
+        annotate_sweep_result &r = results[running[i].index];
+        if (WIFEXITED(status)) {
+          r.status = WEXITSTATUS(status);
+        } else if (WIFSIGNALED(status)) {
+          r.status = -WTERMSIG(status);
+        }
+        __annotate_sweep_parse(running[i].out, r);
+        running.erase(running.begin() + i);
+      }
+    }
+
+    return results;
+  }
+
+#else
+
+  /**
+   * \brief Run a design under several back annotations in parallel
+   * \ingroup Connections
+   *
+   * \tparam root          Root sc_object to annotate, as for annotate_design().
+   * \tparam input_paths   Input JSON files, in the base_name.input.json format.
+   * \tparam duration      Simulation time per run (optional, defaults to running until sc_stop()).
+   * \tparam max_jobs      Maximum number of concurrent workers (optional, defaults to the number of CPUs).
+   * \tparam collect       Callback adding design specific metrics to the result (optional).
+   *
+   * \par Description
+   *      Call after the design is constructed and instead of annotate_design() and sc_start().
+   *      The elaborated simulator is forked once per input file, so elaboration runs only once.
+   *      Each worker annotates root from its input file, runs sc_start(), calls collect, and
+   *      sends the results back through a pipe. Worker stdout and stderr go to
+   *      <input_path>.log, and workers don't write an output.json. Binary channel logs
+   *      (CHANNEL_LOG_BINARY or CHANNEL_LOG_INDEXED) are written per worker, with the index
+   *      of its input file appended to the file name, e.g. channel_logs_data_0.bin. The parent
+   *      process doesn't simulate itself and should not call sc_start() afterwards.
+   *
+   *      The result of each input holds its exit status, the final simulation time and the
+   *      number of cycles of the first clock, plus the metrics from collect. Use
+   *      write_annotate_sweep_csv() to print them as one table.
+   *
+   *      Requires a POSIX host (fork() and pipe()) and CONNECTIONS_ACCURATE_SIM or
+   *      CONNECTIONS_FAST_SIM; otherwise no worker runs and every result has status -1.
+   *
+   * \par A Simple Example
+   * \code
+   *      #include <connections/connections.h>
+   *      #include <connections/annotate_sweep.h>
+   *
+   *      int sc_main(int argc, char *argv[])
+   *      {
+   *        testbench my_testbench("my_testbench");
+   *        std::vector<std::string> inputs(argv + 1, argv + argc);
+   *        std::vector<Connections::annotate_sweep_result> results =
+   *          Connections::annotate_sweep(my_testbench.dut, inputs, sc_time(1, SC_MS), 0,
+   *            [&](std::vector<std::pair<std::string, double> > &m) {
+   *              m.push_back(std::make_pair("packets", my_testbench.sink.count));
+   *            });
+   *        Connections::write_annotate_sweep_csv(results, std::cout);
+   *        return 0;
+   *      }
+   * \endcode
+   * \par
+   *
+   */
+  std::vector<annotate_sweep_result> annotate_sweep(const sc_object &root, const std::vector<std::string> &input_paths,
+                                                    const sc_time &duration = SC_ZERO_TIME, unsigned int max_jobs = 0,
+                                                    annotate_sweep_collect_t collect = annotate_sweep_collect_t())
+  {
+    cerr << "WARNING: Cannot annotate_sweep() unless running in simulation (CONNECTIONS_ACCURATE_SIM or CONNECTIONS_FAST_SIM) on a POSIX host!" << endl;
+    return std::vector<annotate_sweep_result>(input_paths.size());
+  }
+
+#endif
+};
+
+#endif // __CONNECTIONS__ANNOTATE_SWEEP_H__
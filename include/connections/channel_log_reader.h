@@ -0,0 +1,294 @@
+/**************************************************************************
+ *                                                                        *
+ *  HLS Connections Library                                               *
+ *                                                                        *
+ *  Software Version: 2026.2                                              *
+ *                                                                        *
+ *  Release Date    : Tue May 12 21:38:26 PDT 2026                        *
+ *  Release Type    : Production Release                                  *
+ *  Release Build   : 2026.2.0                                            *
+ *                                                                        *
+ *  Copyright 2026 Siemens                                                *
+ *                                                                        *
+ **************************************************************************
+ *  Licensed under the Apache License, Version 2.0 (the "License");       *
+ *  you may not use this file except in compliance with the License.      * 
+ *  You may obtain a copy of the License at                               *
+ *                                                                        *
+ *      http://www.apache.org/licenses/LICENSE-2.0                        *
+ *                                                                        *
+ *  Unless required by applicable law or agreed to in writing, software   * 
+ *  distributed under the License is distributed on an "AS IS" BASIS,     * 
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or       *
+ *  implied.                                                              * 
+ *  See the License for the specific language governing permissions and   * 
+ *  limitations under the License.                                        *
+ **************************************************************************
+ *                                                                        *
+ *  The most recent version of this package is available at github.       *
+ *                                                                        *
+ *************************************************************************/
+
+//*****************************************************************************************
+// channel_log_reader.h
+//
+// Reader for binary channel logs written by channel_logs::enable() with CHANNEL_LOG_BINARY
+// or CHANNEL_LOG_INDEXED, see Connections::channel_log_binary for the file layout. Does not
+// depend on SystemC, so tools can use it as well as testbenches.
+//
+//*****************************************************************************************
+
+#ifndef __CONNECTIONS__CHANNEL_LOG_READER_H__
+#define __CONNECTIONS__CHANNEL_LOG_READER_H__
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef CONNECTIONS_LOG_ZLIB
+#include <zlib.h>
+#endif
+
+namespace Connections
+{
+
+  // Glob match of a full hierarchical name: '*' matches any run of characters including '.',
+  // '?' any one character. Used by channel_name_pattern and channel_log_number().
+  inline bool channel_name_glob_match(const char *s, const char *p)
+  {
+    const char *star = 0, *mark = 0;
+    while (*s) {
+      if (*p == '*') { star = p++; mark = s; }
+      else if (*p && (*p == '?' || *p == *s)) { s++; p++; }
+      else if (star) { p = star + 1; s = ++mark; }
+      else { return false; }
+    }
+    while (*p == '*') { p++; }
+    return !*p;
+  }
+
+  // 64 bit file offsets, logs get well beyond 2 GB. On 32 bit POSIX hosts also build with
+  // -D_FILE_OFFSET_BITS=64.
+  inline unsigned long long channel_log_tell(FILE *fp)
+  {
+#ifdef _WIN32
+    return (unsigned long long)_ftelli64(fp);
+#else
+    return (unsigned long long)ftello(fp);
+#endif
+  }
+
+  inline int channel_log_seek(FILE *fp, long long offset, int whence)
+  {
+#ifdef _WIN32
+    return _fseeki64(fp, offset, whence);
+#else
+    return fseeko(fp, (off_t)offset, whence);
+#endif
+  }
+
+  struct channel_log_record_header {
+    unsigned int log_number;
+    unsigned int bytes;
+    unsigned long long time;   // sc_time value, in units of the log's time resolution
+  };
+
+  class channel_log_reader
+  {
+  public:
+    channel_log_reader() : fp(0), is_indexed(false), compression(0), res_fs(0), res_exp(0) {}
+    ~channel_log_reader() { close(); }
+
+    // Open a .bin or .clog file. On failure returns false and sets error.
+    bool open(const std::string &path) {
+      close();
+      this->path = path;
+      fp = fopen(path.c_str(), "rb");
+      if (!fp) { return fail("Cannot open file '" + path + "'"); }
+
+      char magic[8];
+      if (fread(magic, 1, 8, fp) != 8 || (memcmp(magic, "CONNLOG1", 8) != 0 && memcmp(magic, "CONNLOG2", 8) != 0) ||
+          fread(&res_fs, sizeof(res_fs), 1, fp) != 1) {
+        return fail("'" + path + "' is not a binary channel log");
+      }
+      is_indexed = (memcmp(magic, "CONNLOG2", 8) == 0);
+      unsigned long long r = res_fs;
+      for (res_exp = 0; r >= 10 && (r % 10) == 0; r /= 10) { res_exp++; }
+      if (r != 1) { return fail("'" + path + "' has an unsupported time resolution"); }
+      data_offset = channel_log_tell(fp);
+
+      return is_indexed ? read_index() : true;
+    }
+
+    void close() {
+      if (fp) {
+        fclose(fp);
+        fp = 0;
+      }
+      index.clear();
+    }
+
+    bool indexed() const { return is_indexed; }
+    unsigned long long resolution_fs() const { return res_fs; }
+    int resolution_exp() const { return res_exp; }       // resolution_fs() == 10^resolution_exp()
+    const std::string &last_error() const { return error; }
+
+    // Call f(const channel_log_record_header &, const unsigned char *payload) for every record
+    // whose log number is in channels (sorted, empty selects all) and whose time is within
+    // [from, to], in file order. f may return false to stop early. For indexed logs, only the
+    // blocks that can hold such records are read. Returns false on a read error.
+    template <typename F>
+    bool for_each(const std::vector<unsigned int> &channels, unsigned long long from, unsigned long long to, F f) {
+      if (!fp) { return fail("No channel log open"); }
+      return is_indexed ? for_each_indexed(channels, from, to, f) : for_each_plain(channels, from, to, f);
+    }
+
+    template <typename F>
+    bool for_each(F f) { return for_each(std::vector<unsigned int>(), 0, ~0ull, f); }
+
+  private:
+    struct block_info {
+      unsigned long long offset;
+      unsigned int stored_bytes;
+      unsigned int raw_bytes;
+      unsigned int compressed;
+      unsigned long long first_time;
+      unsigned long long last_time;
+      unsigned int records;
+      std::vector<unsigned int> channels;
+    };
+
+    std::string path;
+    std::string error;
+    FILE *fp;
+    bool is_indexed;
+    unsigned int compression;
+    unsigned long long res_fs;
+    int res_exp;
+    unsigned long long data_offset;
+    std::vector<block_info> index;
+    std::vector<unsigned char> stored, raw;
+
+    bool fail(const std::string &msg) {
+      error = msg;
+      return false;
+    }
+
+    static bool want_channel(const std::vector<unsigned int> &channels, unsigned int c) {
+      return channels.empty() || std::binary_search(channels.begin(), channels.end(), c);
+    }
+
+    bool read_index() {
+      unsigned long long index_offset;
+      unsigned int blocks;
+      char magic[8];
+      if (channel_log_seek(fp, -(long long)(sizeof(index_offset) + 2 * sizeof(unsigned int) + 8), SEEK_END) != 0 ||
+          fread(&index_offset, sizeof(index_offset), 1, fp) != 1 || fread(&blocks, sizeof(blocks), 1, fp) != 1 ||
+          fread(&compression, sizeof(compression), 1, fp) != 1 || fread(magic, 1, 8, fp) != 8 ||
+          (memcmp(magic, "CONNIDX1", 8) != 0 && memcmp(magic, "CONNIDX2", 8) != 0)) {
+        return fail("'" + path + "' has no index, the simulation may not have closed the log");
+      }
+      // CONNIDX1 logs compress all blocks or none, CONNIDX2 logs flag each block.
+      bool per_block = (memcmp(magic, "CONNIDX2", 8) == 0);
+
+      index.resize(blocks);
+      channel_log_seek(fp, (long long)index_offset, SEEK_SET);
+      for (unsigned int i = 0; i < blocks; i++) {
+        block_info &bi = index[i];
+        unsigned int channels = 0;
+        bi.compressed = compression;
+        if (fread(&bi.offset, sizeof(bi.offset), 1, fp) != 1 || fread(&bi.stored_bytes, sizeof(bi.stored_bytes), 1, fp) != 1 ||
+            fread(&bi.raw_bytes, sizeof(bi.raw_bytes), 1, fp) != 1 ||
+            (per_block && fread(&bi.compressed, sizeof(bi.compressed), 1, fp) != 1) ||
+            fread(&bi.first_time, sizeof(bi.first_time), 1, fp) != 1 ||
+            fread(&bi.last_time, sizeof(bi.last_time), 1, fp) != 1 || fread(&bi.records, sizeof(bi.records), 1, fp) != 1 ||
+            fread(&channels, sizeof(channels), 1, fp) != 1) {
+          return fail("'" + path + "' has a corrupt index");
+        }
+        bi.channels.resize(channels);
+        if (channels && fread(&bi.channels[0], sizeof(unsigned int), channels, fp) != channels) {
+          return fail("'" + path + "' has a corrupt index");
+        }
+#ifndef CONNECTIONS_LOG_ZLIB
+        if (bi.compressed != 0) { return fail("'" + path + "' is compressed, build with CONNECTIONS_LOG_ZLIB and zlib"); }
+#endif
+      }
+      return true;
+    }
+
+    template <typename F>
+    bool for_each_plain(const std::vector<unsigned int> &channels, unsigned long long from, unsigned long long to, F f) {
+      channel_log_seek(fp, (long long)data_offset, SEEK_SET);
+      channel_log_record_header hdr;
+      while (fread(&hdr, sizeof(hdr), 1, fp) == 1) {
+        raw.resize(hdr.bytes + 1);
+        if (hdr.bytes && fread(&raw[0], 1, hdr.bytes, fp) != hdr.bytes) { return fail("'" + path + "' is truncated"); }
+        if (hdr.time > to) { break; }
+        if (hdr.time >= from && want_channel(channels, hdr.log_number) && !f(hdr, (const unsigned char *)&raw[0])) { break; }
+      }
+      return true;
+    }
+
+    template <typename F>
+    bool for_each_indexed(const std::vector<unsigned int> &channels, unsigned long long from, unsigned long long to, F f) {
+      for (std::size_t i = 0; i < index.size(); i++) {
+        const block_info &bi = index[i];
+        if (bi.first_time > to) { break; }
+        if (bi.last_time < from) { continue; }
+        bool any = channels.empty();
+        for (std::size_t c = 0; !any && c < bi.channels.size(); c++) { any = want_channel(channels, bi.channels[c]); }
+        if (!any) { continue; }
+
+        stored.resize(bi.stored_bytes + 1);
+        channel_log_seek(fp, (long long)bi.offset, SEEK_SET);
+        if (fread(&stored[0], 1, bi.stored_bytes, fp) != bi.stored_bytes) { return fail("'" + path + "' is truncated"); }
+        const unsigned char *p = &stored[0];
+#ifdef CONNECTIONS_LOG_ZLIB
+        if (bi.compressed == 1) {
+          raw.resize(bi.raw_bytes + 1);
+          uLongf len = bi.raw_bytes;
+          if (uncompress(&raw[0], &len, &stored[0], bi.stored_bytes) != Z_OK || len != bi.raw_bytes) {
+            return fail("'" + path + "' has a corrupt block");
+          }
+          p = &raw[0];
+        }
+#endif
+        channel_log_record_header hdr;
+        for (std::size_t pos = 0; pos + sizeof(hdr) <= bi.raw_bytes; pos += sizeof(hdr) + hdr.bytes) {
+          memcpy(&hdr, p + pos, sizeof(hdr));
+          if (pos + sizeof(hdr) + hdr.bytes > bi.raw_bytes) { return fail("'" + path + "' has a corrupt block"); }
+          if (hdr.time > to) { return true; }
+          if (hdr.time >= from && want_channel(channels, hdr.log_number) && !f(hdr, p + pos + sizeof(hdr))) { return true; }
+        }
+      }
+      return true;
+    }
+  };
+
+  // Look up the log number of a channel in a channel_logs_names.txt file. name may be a glob
+  // pattern ('*' and '?'), the first matching channel is returned. Returns -1 if none matches.
+  inline int channel_log_number(const std::string &names_path, const std::string &name)
+  {
+    std::ifstream ifs(names_path.c_str());
+    std::string line;
+    bool glob = (name.find_first_of("*?") != std::string::npos);
+    while (std::getline(ifs, line)) {
+      std::istringstream is(line);
+      int num;
+      std::string path_name;
+      if (!(is >> num >> path_name)) { continue; }
+      if (glob) {
+        if (channel_name_glob_match(path_name.c_str(), name.c_str())) { return num; }
+      } else if (path_name == name) {
+        return num;
+      }
+    }
+    return -1;
+  }
+
+}
+
+#endif // __CONNECTIONS__CHANNEL_LOG_READER_H__
@@ -100,8 +100,16 @@
 #ifdef CONNECTIONS_SIM_ONLY
 #include <iomanip>
 #include <vector>
+#include <deque>
+#include <cstring>
 #include <map>
+#include <memory>
+#include <set>
+#include <algorithm>
 #include <type_traits>
+#ifdef CONNECTIONS_PROFILE
+#include <chrono>
+#endif
 #include <tlm.h>
 #if !defined(NC_SYSTEMC) && !defined(XM_SYSTEMC) && !defined(NO_SC_RESET_INCLUDE)
 #include <sysc/kernel/sc_reset.h>
@@ -387,12 +395,12 @@ namespace Connections
 
   // Enable debug for custom types in simulation
   // primary template
-  template <typename T, typename = void>
-  class dbg_signal : public sc_signal<T>
+  template <typename T, typename = void, sc_writer_policy POL = SC_DEFAULT_WRITER_POLICY>
+  class dbg_signal : public sc_signal<T, POL>
   {
   public:
     dbg_signal() {}
-    dbg_signal(const char* s) : sc_signal<T>(s) {}
+    dbg_signal(const char* s) : sc_signal<T, POL>(s) {}
   };
 
 #if defined(CONNECTIONS_CUSTOM_DEBUG) && !defined(__SYNTHESIS__)
@@ -406,13 +414,13 @@ namespace Connections
     : std::true_type {};
 
   // specialization for types that have a marshall method (needs custom debug callback in vsim)
-  template <typename T>
-  class dbg_signal<T,  typename std::enable_if<has_Marshall_method<T>::value>::type>
-    : public sc_signal<T>
+  template <typename T, sc_writer_policy POL>
+  class dbg_signal<T,  typename std::enable_if<has_Marshall_method<T>::value>::type, POL>
+    : public sc_signal<T, POL>
   {
   public:
     dbg_signal() { do_reg(); }
-    dbg_signal(const char* s) : sc_signal<T>(s) { do_reg(); }
+    dbg_signal(const char* s) : sc_signal<T, POL>(s) { do_reg(); }
 
     static const int maxlen = 100;
 
@@ -427,13 +435,21 @@ namespace Connections
 
     void do_reg() {
 #ifdef SC_MTI_REGISTER_CUSTOM_DEBUG
-     sc_signal<T>* sig = this;
+     sc_signal<T, POL>* sig = this;
      SC_MTI_REGISTER_CUSTOM_DEBUG(sig, maxlen, debug_cb);
 #endif
     }
   };
 #endif // CONNECTIONS_CUSTOM_DEBUG
 
+  // With CONNECTIONS_DISABLE_MARSHALL_CHECKS the per-field Marshaller checks are compiled
+  // out, so MARSHALL_PORT ports validate their message width once at construction instead.
+#if defined(CONNECTIONS_DISABLE_MARSHALL_CHECKS) && !defined(__SYNTHESIS__)
+#define CONNECTIONS_MARSHALL_WIDTH_CHECK(T) marshall_width_check<T>::check()
+#else
+#define CONNECTIONS_MARSHALL_WIDTH_CHECK(T)
+#endif
+
   template <class T>
   T
   static convert_from_lv(sc_lv<Wrapped<T>::width> lv) {
@@ -677,6 +693,105 @@ namespace Connections
     }
   };
 
+  // Name of a port or channel from the name of its valid signal, for reports and traces.
+  inline std::string channel_base_name(const char *vld_name, const char *vld_suffix)
+  {
+    std::string name(vld_name);
+    std::string nameSuff = "_";
+    nameSuff += vld_suffix;
+    unsigned int suffLen = nameSuff.length();
+    if (name.length() > suffLen && name.substr(name.length() - suffLen, suffLen) == nameSuff) { name.erase(name.length() - suffLen, suffLen); }
+    return name;
+  }
+
+#ifdef CONNECTIONS_CHANNEL_STATS
+  // Activity counters of a port or back-annotated channel, sampled once per clock cycle
+  // from its Pre(). See ConManager::write_channel_stats().
+  struct channel_stats {
+    unsigned long long cycles;
+    unsigned long long transfers;      // valid and ready
+    unsigned long long backpressure;   // valid, not ready
+    unsigned long long starvation;     // ready, not valid
+    unsigned long long occupancy_sum;  // BA buffer occupancy summed over cycles
+    unsigned int occupancy_max;
+    unsigned int capacity;
+
+    channel_stats() { clear(); }
+
+    void clear() {
+      cycles = transfers = backpressure = starvation = occupancy_sum = 0;
+      occupancy_max = capacity = 0;
+    }
+
+    inline void sample(bool vld, bool rdy) {
+      cycles++;
+      if (vld) {
+        if (rdy) { transfers++; }
+        else { backpressure++; }
+      } else if (rdy) {
+        starvation++;
+      }
+    }
+
+    inline void sample_occupancy(unsigned int used, unsigned int size) {
+      occupancy_sum += used;
+      if (used > occupancy_max) { occupancy_max = used; }
+      capacity = size;
+    }
+  };
+
+  // Push to Pop latency of a channel in cycles, in log2 buckets: bucket 0 counts latency 0,
+  // bucket b counts [2^(b-1), 2^b). See track_channel_latency().
+  struct latency_histogram {
+    static const unsigned int num_buckets = 33;
+    unsigned long long buckets[num_buckets];
+    unsigned long long count;
+    unsigned long long sum;
+    unsigned long max;
+
+    latency_histogram() { clear(); }
+
+    void clear() {
+      for (unsigned int b = 0; b < num_buckets; b++) { buckets[b] = 0; }
+      count = sum = max = 0;
+    }
+
+    inline void add(unsigned long cycles) {
+      unsigned int b = 0;
+      while (b + 1 < num_buckets && (cycles >> b)) { b++; }
+      buckets[b]++;
+      count++;
+      sum += cycles;
+      if (cycles > max) { max = cycles; }
+    }
+
+    double mean() const { return count ? (double)sum / count : 0; }
+
+    // Latency below which a fraction p of the messages fall, interpolated within its bucket.
+    double percentile(double p) const {
+      if (count == 0) { return 0; }
+      double target = p * count;
+      if (target < 1) { target = 1; }
+      unsigned long long seen = 0;
+      for (unsigned int b = 0; b < num_buckets; b++) {
+        if (buckets[b] == 0 || seen + buckets[b] < target) {
+          seen += buckets[b];
+          continue;
+        }
+        double lo = b ? (double)(1ull << (b - 1)) : 0;
+        double hi = b ? (double)((1ull << b) - 1) : 0;
+        double v = lo + (hi - lo) * (target - seen) / buckets[b];
+        return (v < max) ? v : max;
+      }
+      return max;
+    }
+  };
+
+#endif
+
+  // Report formats of the channel stats, backpressure and profile reports.
+  enum channel_stats_format {CHANNEL_STATS_CSV=0, CHANNEL_STATS_JSON=1};
+
 // this is an abstract class for both blocking connections
 // it is used to allow a containter of pointers to any blocking connection
   class Blocking_abs
@@ -691,6 +806,7 @@ namespace Connections
     virtual bool PrePostReset()  {return false;};
     virtual std::string full_name() { return "unnamed"; }
     bool clock_registered{0};
+    bool in_sweep{0}; // in ConManager's Pre()/Post() sweep of its clock
     bool non_leaf_port{0};
     bool disable_spawn_true{0};
     virtual void disable_spawn() {}
@@ -698,7 +814,244 @@ namespace Connections
     virtual bool do_reset_check() {return 0;}
     virtual std::string report_name() {return std::string("unnamed"); }
     Blocking_abs *sibling_port{0};
+#ifdef CONNECTIONS_CHANNEL_STATS
+    channel_stats stats;
+    bool stats_stalled{0}; // Out ports: valid and not ready in the last sampled cycle
+    virtual std::string stats_name() { return full_name(); }
+    virtual const char *stats_kind() { return "port"; }
+    // Valid signal the port is bound to, or for a channel its input (out_side false) or
+    // output valid signal. Used to build the channel graph for backpressure_analyzer.
+    virtual const sc_object *stats_signal(bool out_side) { return 0; }
+    // Module that pushes or pops through the port.
+    virtual const sc_object *stats_module() { return 0; }
+#endif
+  };
+
+#ifdef CONNECTIONS_CHANNEL_STATS
+  // Traces backpressure back to the channels that cause it, see analyze_backpressure().
+  //
+  // The channel graph is built from the ports ConManager tracks: a channel connects the leaf
+  // Out port of its producer module to the leaf In port of its consumer module, either through
+  // one signal or through a Combinational. A channel is stalled in a cycle when its producer
+  // holds valid without ready. If the consumer module is itself stalled pushing to one of its
+  // own output channels, the stall is passed on to that channel, otherwise the channel is a
+  // root cause: its consumer doesn't keep up. Each stall cycle is charged to every root it
+  // leads to.
+  class backpressure_analyzer
+  {
+  public:
+    struct channel_info {
+      std::string name;
+      Blocking_abs *producer;          // leaf Out port
+      const sc_object *producer_module;
+      const sc_object *consumer_module;
+      std::vector<unsigned> outputs;   // channels pushed by the consumer module
+      unsigned long long stall_cycles;  // cycles stalled
+      unsigned long long root_cycles;   // cycles stalled as a root cause
+      unsigned long long caused_cycles; // stall cycles of all channels charged to it
+      unsigned long mark;
+
+      channel_info() : producer(0), producer_module(0), consumer_module(0),
+        stall_cycles(0), root_cycles(0), caused_cycles(0), mark(0) {}
+    };
+
+    backpressure_analyzer() : built(false), epoch(0) {}
+
+    std::vector<channel_info> channels;
+
+    // Account one cycle of clock clk, after ConManager's Pre() sweep has sampled its ports.
+    void cycle(int clk, const std::vector<Blocking_abs *> &tracked) {
+      if (!built) { build(tracked); }
+      for (unsigned c = 0; c < channels.size(); c++) {
+        channel_info &ch = channels[c];
+        if (ch.producer->clock_number != clk || !ch.producer->stats_stalled) { continue; }
+        ch.stall_cycles++;
+        ++epoch;
+        roots.clear();
+        find_roots(c);
+        for (unsigned r = 0; r < roots.size(); r++) {
+          channels[roots[r]].caused_cycles++;
+          if (roots[r] == c) { ch.root_cycles++; }
+        }
+      }
+    }
+
+    // Channels that caused stalls, most stall cycles caused first.
+    void write(std::ostream &os, int format) {
+      std::vector<unsigned> order;
+      for (unsigned c = 0; c < channels.size(); c++) {
+        if (channels[c].caused_cycles) { order.push_back(c); }
+      }
+      std::stable_sort(order.begin(), order.end(), by_caused(channels));
+      bool json = (format == CHANNEL_STATS_JSON);
+      if (json) { os << "{\n  \"time\": \"" << sc_time_stamp() << "\",\n  \"root_causes\": ["; }
+      else { os << "rank,channel,consumer,caused_cycles,root_cycles,stall_cycles\n"; }
+      for (unsigned i = 0; i < order.size(); i++) {
+        const channel_info &ch = channels[order[i]];
+        const char *consumer = ch.consumer_module ? ch.consumer_module->name() : "";
+        if (json) {
+          os << (i ? ",\n" : "\n") << "    {\"rank\": " << (i + 1) << ", \"channel\": \"" << json_escape(ch.name)
+             << "\", \"consumer\": \"" << json_escape(consumer) << "\", \"caused_cycles\": " << ch.caused_cycles
+             << ", \"root_cycles\": " << ch.root_cycles << ", \"stall_cycles\": " << ch.stall_cycles << "}";
+        } else {
+          os << (i + 1) << ",\"" << ch.name << "\",\"" << consumer << "\"," << ch.caused_cycles << ","
+             << ch.root_cycles << "," << ch.stall_cycles << "\n";
+        }
+      }
+      if (json) { os << "\n  ]\n}\n"; }
+    }
+
+  private:
+    bool built;
+    unsigned long epoch;
+    std::vector<unsigned> roots;
+
+    struct by_caused {
+      const std::vector<channel_info> &channels;
+      by_caused(const std::vector<channel_info> &channels) : channels(channels) {}
+      bool operator()(unsigned a, unsigned b) const { return channels[a].caused_cycles > channels[b].caused_cycles; }
+    };
+
+    void find_roots(unsigned c) {
+      channel_info &ch = channels[c];
+      if (ch.mark == epoch) { return; }
+      ch.mark = epoch;
+      bool passed_on = false;
+      // A stall that loops back to a channel already visited (a cycle in the channel graph)
+      // is charged to the channel that closes the loop.
+      for (unsigned i = 0; i < ch.outputs.size(); i++) {
+        channel_info &out = channels[ch.outputs[i]];
+        if (out.producer->stats_stalled && out.mark != epoch) {
+          passed_on = true;
+          find_roots(ch.outputs[i]);
+        }
+      }
+      if (!passed_on) { roots.push_back(c); }
+    }
+
+    unsigned channel_of(std::map<const sc_object *, unsigned> &by_signal, const sc_object *sig) {
+      std::map<const sc_object *, unsigned>::iterator it = by_signal.find(sig);
+      if (it != by_signal.end()) { return it->second; }
+      channels.push_back(channel_info());
+      channels.back().name = sig ? sig->name() : "unbound";
+      return by_signal[sig] = channels.size() - 1;
+    }
+
+    void build(const std::vector<Blocking_abs *> &tracked) {
+      built = true;
+      std::map<const sc_object *, unsigned> by_signal;
+      for (unsigned i = 0; i < tracked.size(); i++) {
+        if (std::string(tracked[i]->stats_kind()) != "channel") { continue; }
+        unsigned c = channel_of(by_signal, tracked[i]->stats_signal(false));
+        channels[c].name = tracked[i]->stats_name();
+        by_signal[tracked[i]->stats_signal(true)] = c;
+      }
+      for (unsigned i = 0; i < tracked.size(); i++) {
+        std::string kind(tracked[i]->stats_kind());
+        if (kind == "out") {
+          channel_info &ch = channels[channel_of(by_signal, tracked[i]->stats_signal(true))];
+          ch.producer = tracked[i];
+          ch.producer_module = tracked[i]->stats_module();
+        } else if (kind == "in") {
+          channels[channel_of(by_signal, tracked[i]->stats_signal(false))].consumer_module = tracked[i]->stats_module();
+        }
+      }
+      // Keep channels with a producer, and link each to the channels its consumer pushes.
+      std::vector<channel_info> kept;
+      for (unsigned c = 0; c < channels.size(); c++) {
+        if (channels[c].producer) { kept.push_back(channels[c]); }
+      }
+      channels.swap(kept);
+      std::map<const sc_object *, std::vector<unsigned> > by_producer;
+      for (unsigned c = 0; c < channels.size(); c++) {
+        if (channels[c].producer_module) { by_producer[channels[c].producer_module].push_back(c); }
+      }
+      for (unsigned c = 0; c < channels.size(); c++) {
+        if (!channels[c].consumer_module) { continue; }
+        std::map<const sc_object *, std::vector<unsigned> >::const_iterator it = by_producer.find(channels[c].consumer_module);
+        if (it != by_producer.end()) { channels[c].outputs = it->second; }
+      }
+    }
   };
+#endif
+
+#ifdef CONNECTIONS_PROFILE
+  // Host and simulated time each process spends in blocking Connections calls, see
+  // report_connections_profile(). Calls are recorded by connections_profile_scope.
+  class connections_profiler
+  {
+  public:
+    typedef std::chrono::steady_clock host_clock;
+
+    struct port_info {
+      std::string name;
+      unsigned long long calls;          // blocking calls
+      unsigned long long blocked_calls;  // calls that had to wait
+      unsigned long long blocked_cycles; // clock cycles spent waiting
+      port_info() : calls(0), blocked_calls(0), blocked_cycles(0) {}
+    };
+
+    struct process_info {
+      std::string name;
+      double host_compute;   // seconds from leaving one blocking call to entering the next
+      double host_blocked;   // seconds inside blocking calls, mostly spent running other processes
+      unsigned long long skipped_intervals; // intervals left out of host_compute, the thread waited in them
+      bool has_exit;
+      host_clock::time_point last_exit;
+      sc_dt::uint64 last_exit_delta;
+      std::map<const Blocking_abs *, port_info> ports;
+      process_info() : host_compute(0), host_blocked(0), skipped_intervals(0), has_exit(false), last_exit_delta(0) {}
+    };
+
+    std::map<const sc_object *, process_info> processes;
+
+    void write(std::ostream &os, int format) {
+      bool json = (format == CHANNEL_STATS_JSON);
+      if (json) { os << "{\n  \"time\": \"" << sc_time_stamp() << "\",\n  \"processes\": ["; }
+      else { os << "process,host_compute_s,host_blocked_s,skipped_intervals,rank,port,calls,blocked_calls,blocked_cycles\n"; }
+      // Processes that compute longest first.
+      std::vector<const process_info *> procs;
+      for (process_iterator p = processes.begin(); p != processes.end(); ++p) { procs.push_back(&p->second); }
+      std::stable_sort(procs.begin(), procs.end(), by_compute);
+      for (unsigned n = 0; n < procs.size(); n++) {
+        const process_info &pi = *procs[n];
+        std::vector<const port_info *> ports;
+        for (std::map<const Blocking_abs *, port_info>::const_iterator it = pi.ports.begin(); it != pi.ports.end(); ++it) {
+          ports.push_back(&it->second);
+        }
+        std::stable_sort(ports.begin(), ports.end(), by_blocked);
+        if (json) {
+          os << (n ? ",\n" : "\n") << "    {\"process\": \"" << json_escape(pi.name) << "\", \"host_compute_s\": " << pi.host_compute
+             << ", \"host_blocked_s\": " << pi.host_blocked << ", \"skipped_intervals\": " << pi.skipped_intervals
+             << ", \"ports\": [";
+        }
+        for (unsigned i = 0; i < ports.size(); i++) {
+          const port_info &po = *ports[i];
+          if (json) {
+            os << (i ? ",\n" : "\n") << "      {\"rank\": " << (i + 1) << ", \"port\": \"" << json_escape(po.name) << "\", \"calls\": "
+               << po.calls << ", \"blocked_calls\": " << po.blocked_calls << ", \"blocked_cycles\": " << po.blocked_cycles << "}";
+          } else {
+            os << "\"" << pi.name << "\"," << pi.host_compute << "," << pi.host_blocked << "," << pi.skipped_intervals
+               << "," << (i + 1) << ",\""
+               << po.name << "\"," << po.calls << "," << po.blocked_calls << "," << po.blocked_cycles << "\n";
+          }
+        }
+        if (json) { os << "\n    ]}"; }
+      }
+      if (json) { os << "\n  ]\n}\n"; }
+    }
+
+  private:
+    typedef std::map<const sc_object *, process_info>::const_iterator process_iterator;
+
+    static bool by_compute(const process_info *a, const process_info *b) { return a->host_compute > b->host_compute; }
+
+    static bool by_blocked(const port_info *a, const port_info *b) {
+      if (a->blocked_cycles != b->blocked_cycles) { return a->blocked_cycles > b->blocked_cycles; }
+      return a->blocked_calls > b->blocked_calls;
+    }
+  };
+#endif
 
 
   class ConManager
@@ -770,8 +1123,15 @@ namespace Connections
     std::map<int, process_reset_info> map_clk_to_reset_info;
     std::map<sc_process_b *, process_reset_info> map_process_to_reset_info;
     bool sim_clk_initialized;
+    bool registration_checked{0};
 
     std::vector<std::vector<Blocking_abs *>*> tracked_per_clk;
+#ifdef CONNECTIONS_CHANNEL_STATS
+    backpressure_analyzer *backpressure{0}; // see analyze_backpressure()
+#endif
+#ifdef CONNECTIONS_PROFILE
+    connections_profiler *profiler{0}; // see report_connections_profile()
+#endif
 
     void init_sim_clk() {
       if (sim_clk_initialized) { return; }
@@ -870,6 +1230,7 @@ namespace Connections
           if (tracked[i]->sibling_port) {
             tracked[i]->clock_number = clock_number;
             tracked[i]->clock_registered = true;
+            tracked[i]->in_sweep = true;
             tracked_per_clk[tracked[i]->clock_number]->push_back(tracked[i]);
             continue;
           }
@@ -905,6 +1266,28 @@ namespace Connections
               SC_REPORT_WARNING("CONNECTIONS-212", ss.str().c_str());
             }
       }
+
+      registration_checked = true;
+    }
+
+    // Register a port for Pre()/Post() once check_registration() has already run, e.g. a
+    // Combinational channel that is re-annotated from latency 0 during simulation.
+    void add_clock_late(Blocking_abs *c) {
+      if (! registration_checked) { return; } // check_registration() will pick it up through sibling_port.
+
+      Blocking_abs *sib = c;
+      while (! sib->clock_registered && sib->sibling_port) { sib = sib->sibling_port; }
+      if (! sib->clock_registered) {
+        SC_REPORT_ERROR("CONNECTIONS-125",
+          std::string("Unable to resolve clock on port - check and fix any prior warnings about missing Reset() on ports: ").c_str());
+        return;
+      }
+      c->clock_number = sib->clock_number;
+      c->clock_registered = true;
+
+      if (c->in_sweep) { return; }
+      c->in_sweep = true;
+      tracked_per_clk[c->clock_number]->push_back(c);
     }
 
     void add_clock_event(Blocking_abs *c) {
@@ -958,6 +1341,7 @@ namespace Connections
       --clk; // undo +1 encoding for errors
 
       tracked_per_clk[clk]->push_back(c);
+      c->in_sweep = true;
       c->clock_number = clk;
       DBG_CONNECT("add_clock_event: port " << std::hex << c << " clock_number " << clk << " process " << h.name());
 
@@ -1081,31 +1465,129 @@ namespace Connections
       CONNECTIONS_ASSERT_MSG(0, "Couldn't find port to remove from ConManager back-annotation tracking!");
     }
 
+#ifdef CONNECTIONS_CHANNEL_STATS
+    std::vector<channel_name_pattern> latency_patterns;
+    std::map<std::string, latency_histogram> latency_histograms;
+
+    void track_latency(const std::string &pattern, bool is_regex = false) {
+      latency_patterns.push_back(channel_name_pattern(pattern, is_regex));
+    }
+
+    // Histogram for a channel, or 0 if it isn't selected by track_latency(). Channels ask once,
+    // when they first run.
+    latency_histogram *get_latency_histogram(const std::string &name) {
+      for (unsigned i = 0; i < latency_patterns.size(); i++) {
+        if (latency_patterns[i].match(name)) { return &latency_histograms[name]; }
+      }
+      return 0;
+    }
+
+    // Write the counters of every port and channel that took part in the Pre()/Post() sweep,
+    // and the latency histograms, one record each, as CSV or JSON.
+    void write_channel_stats(std::ostream &os, int format = CHANNEL_STATS_CSV) {
+      bool json = (format == CHANNEL_STATS_JSON);
+      bool first = true;
+      std::set<std::string> written;
+      if (json) { os << "{\n  \"time\": \"" << sc_time_stamp() << "\",\n  \"channels\": ["; }
+      else { os << "name,kind,cycles,transfers,backpressure,starvation,throughput,occupancy_avg,occupancy_max,capacity,"
+                << "latency_count,latency_avg,latency_p50,latency_p90,latency_p99,latency_max\n"; }
+      for (unsigned i = 0; i < tracked.size(); i++) {
+        const channel_stats &st = tracked[i]->stats;
+        if (st.cycles == 0) { continue; }
+        std::string name = tracked[i]->stats_name();
+        double throughput = (double)st.transfers / st.cycles;
+        double occupancy = (double)st.occupancy_sum / st.cycles;
+        if (json) {
+          os << (first ? "\n" : ",\n")
+             << "    {\"name\": \"" << json_escape(name) << "\", \"kind\": \"" << tracked[i]->stats_kind()
+             << "\", \"cycles\": " << st.cycles << ", \"transfers\": " << st.transfers
+             << ", \"backpressure\": " << st.backpressure << ", \"starvation\": " << st.starvation
+             << ", \"throughput\": " << throughput << ", \"occupancy_avg\": " << occupancy
+             << ", \"occupancy_max\": " << st.occupancy_max << ", \"capacity\": " << st.capacity;
+        } else {
+          os << "\"" << name << "\"," << tracked[i]->stats_kind() << "," << st.cycles << ","
+             << st.transfers << "," << st.backpressure << "," << st.starvation << "," << throughput << ","
+             << occupancy << "," << st.occupancy_max << "," << st.capacity;
+        }
+        std::map<std::string, latency_histogram>::const_iterator h = latency_histograms.find(name);
+        if (h != latency_histograms.end() && written.insert(name).second) { write_latency(os, json, h->second); }
+        else if (!json) { os << ",,,,,,"; }
+        os << (json ? "}" : "\n");
+        first = false;
+      }
+      // Channels that aren't swept by ConManager, e.g. Fifo.
+      for (std::map<std::string, latency_histogram>::const_iterator h = latency_histograms.begin(); h != latency_histograms.end(); ++h) {
+        if (written.count(h->first)) { continue; }
+        if (json) { os << (first ? "\n" : ",\n") << "    {\"name\": \"" << json_escape(h->first) << "\", \"kind\": \"fifo\""; }
+        else { os << "\"" << h->first << "\",fifo,,,,,,,,"; }
+        write_latency(os, json, h->second);
+        os << (json ? "}" : "\n");
+        first = false;
+      }
+      if (json) { os << "\n  ]\n}\n"; }
+    }
+
+    void write_latency(std::ostream &os, bool json, const latency_histogram &h) {
+      if (json) {
+        os << ", \"latency\": {\"count\": " << h.count << ", \"avg\": " << h.mean()
+           << ", \"p50\": " << h.percentile(0.50) << ", \"p90\": " << h.percentile(0.90)
+           << ", \"p99\": " << h.percentile(0.99) << ", \"max\": " << h.max << ", \"buckets\": [";
+        unsigned int last = latency_histogram::num_buckets;
+        while (last > 1 && h.buckets[last - 1] == 0) { last--; }
+        for (unsigned int b = 0; b < last; b++) { os << (b ? ", " : "") << h.buckets[b]; }
+        os << "]}";
+      } else {
+        os << "," << h.count << "," << h.mean() << "," << h.percentile(0.50) << "," << h.percentile(0.90)
+           << "," << h.percentile(0.99) << "," << h.max;
+      }
+    }
+
+    bool write_channel_stats(const std::string &path, int format = CHANNEL_STATS_CSV) {
+      std::ofstream ofs(path.c_str());
+      if (!ofs.is_open()) {
+        SC_REPORT_WARNING("CONNECTIONS-501", ("Cannot open channel stats file '" + path + "'").c_str());
+        return false;
+      }
+      write_channel_stats(ofs, format);
+      return true;
+    }
+
+    void clear_channel_stats() {
+      for (unsigned i = 0; i < tracked.size(); i++) { tracked[i]->stats.clear(); }
+      for (std::map<std::string, latency_histogram>::iterator h = latency_histograms.begin(); h != latency_histograms.end(); ++h) {
+        h->second.clear();
+      }
+    }
+#endif
+
+    // Call Pre() or Post() of every port in v, dropping those that return false in one pass,
+    // e.g. all bypass channels in the first cycle.
+    void sweep(std::vector<Blocking_abs *> &v, bool pre) {
+      std::size_t kept = 0;
+      for (std::size_t i = 0; i < v.size(); i++) {
+        if (pre ? v[i]->Pre() : v[i]->Post()) {
+          v[kept++] = v[i];
+        } else {
+          v[i]->in_sweep = false;
+        }
+      }
+      v.resize(kept);
+    }
+
     void run(int clk) {
       get_sim_clk().post_delay(clk);  // align to occur just after the cycle
 
       SimConnectionsClk::clk_info &ci = get_sim_clk().clk_info_vector[clk];
 
       while (1) {
-        // Post();
-        for (std::vector<Blocking_abs *>::iterator it=tracked_per_clk[clk]->begin(); it!=tracked_per_clk[clk]->end(); ) {
-          if ((*it)->Post()) {
-            ++it;
-          } else {
-            tracked_per_clk[clk]->erase(it);
-          }
-        }
+        sweep(*tracked_per_clk[clk], false); // Post();
 
         get_sim_clk().post2pre_delay(clk);
 
-        //Pre();
-        for (std::vector<Blocking_abs *>::iterator it=tracked_per_clk[clk]->begin(); it!=tracked_per_clk[clk]->end(); ) {
-          if ((*it)->Pre()) {
-            ++it;
-          } else {
-            tracked_per_clk[clk]->erase(it);
-          }
-        }
+        sweep(*tracked_per_clk[clk], true); //Pre();
+#ifdef CONNECTIONS_CHANNEL_STATS
+        if (backpressure) { backpressure->cycle(clk, tracked); }
+#endif
         ci.clock_edge += ci.period_delay;
 
         if (ci.do_sync_reset || ci.do_async_reset) {
@@ -1170,6 +1652,277 @@ namespace Connections
     return ConManager_statics<void>::conManager;
   }
 
+#ifdef CONNECTIONS_CHANNEL_STATS
+  class __channel_stats_reporter : public sc_module
+  {
+  public:
+    __channel_stats_reporter(sc_module_name name, const std::string &path, int format)
+      : sc_module(name), path(path), format(format) {}
+
+    void end_of_simulation() {
+      get_conManager().write_channel_stats(path, format);
+    }
+
+  private:
+    std::string path;
+    int format;
+  };
+
+  /**
+   * \brief Write per-channel activity counters when the simulation ends.
+   * \ingroup Connections
+   *
+   * Only available when CONNECTIONS_CHANNEL_STATS is defined, the counters compile out
+   * otherwise. Every MARSHALL_PORT and DIRECT_PORT Out<> and In<> port (the default in
+   * CONNECTIONS_ACCURATE_SIM) and every back-annotated Combinational channel counts, per
+   * clock cycle: transfers (valid and ready), backpressure (valid, not ready), starvation
+   * (ready, not valid) and, for back-annotated channels, the occupancy of the channel buffer.
+   * Latency histograms of the channels selected by track_channel_latency() are part of the
+   * same report.
+   *
+   * Must be called before sc_start(); the report is written from end_of_simulation(),
+   * i.e. after sc_stop(). get_conManager().write_channel_stats() writes the same report
+   * at any other point.
+   *
+   * \par A Simple Example
+   * \code
+   *      #define CONNECTIONS_CHANNEL_STATS
+   *      #include <connections/connections.h>
+   *
+   *      int sc_main(int argc, char *argv[])
+   *      {
+   *      ...
+   *      Connections::report_channel_stats("channel_stats.csv");
+   *      sc_start();
+   *      ...
+   *      }
+   * \endcode
+   * \par
+   *
+   */
+  inline void report_channel_stats(const std::string &path, int format = CHANNEL_STATS_CSV)
+  {
+    new __channel_stats_reporter(sc_gen_unique_name("channel_stats_reporter"), path, format);
+  }
+
+  /**
+   * \brief Collect Push to Pop latency histograms of channels selected by name.
+   * \ingroup Connections
+   *
+   * Only available when CONNECTIONS_CHANNEL_STATS is defined. Selects back-annotated
+   * Combinational channels and Fifo modules whose full name matches pattern, a glob or,
+   * with is_regex, an ECMAScript regex. Latency is counted in cycles from the cycle a
+   * message enters the channel buffer to the cycle it leaves it, in log2 buckets; the
+   * report written by report_channel_stats() gives count, mean, p50, p90, p99 and max,
+   * and the JSON report the buckets too. Channels with latency 0 have no buffer and are
+   * not measured.
+   *
+   * \par A Simple Example
+   * \code
+   *      #define CONNECTIONS_CHANNEL_STATS
+   *      #include <connections/connections.h>
+   *
+   *      int sc_main(int argc, char *argv[])
+   *      {
+   *      ...
+   *      Connections::track_channel_latency("top.noc.*");
+   *      Connections::report_channel_stats("channel_stats.json", Connections::CHANNEL_STATS_JSON);
+   *      sc_start();
+   *      ...
+   *      }
+   * \endcode
+   * \par
+   *
+   */
+  inline void track_channel_latency(const std::string &pattern, bool is_regex = false)
+  {
+    get_conManager().track_latency(pattern, is_regex);
+  }
+
+  class __backpressure_reporter : public sc_module
+  {
+  public:
+    __backpressure_reporter(sc_module_name name, const std::string &path, int format)
+      : sc_module(name), path(path), format(format) {}
+
+    void end_of_simulation() {
+      std::ofstream ofs(path.c_str());
+      if (!ofs.is_open()) {
+        SC_REPORT_WARNING("CONNECTIONS-501", ("Cannot open backpressure report file '" + path + "'").c_str());
+        return;
+      }
+      get_conManager().backpressure->write(ofs, format);
+    }
+
+  private:
+    std::string path;
+    int format;
+  };
+
+  /**
+   * \brief Rank the channels that are the root cause of backpressure.
+   * \ingroup Connections
+   *
+   * Only available when CONNECTIONS_CHANNEL_STATS is defined. Every clock cycle, each
+   * channel whose producer holds valid without ready is followed downstream through the
+   * binding graph: if the consumer module is itself stalled pushing to one of its output
+   * channels, the stall is passed on, otherwise the channel is a root cause. The report
+   * lists root causes, most stall cycles caused first, with the consumer module, the
+   * stall cycles charged to the channel (caused_cycles), the cycles it was stalled as a
+   * root itself (root_cycles) and all cycles it was stalled (stall_cycles).
+   *
+   * Producers are MARSHALL_PORT and DIRECT_PORT Out<> ports; modules are matched by the
+   * parent of the port. Must be called before sc_start(); the report is written from
+   * end_of_simulation().
+   *
+   * \par A Simple Example
+   * \code
+   *      #define CONNECTIONS_CHANNEL_STATS
+   *      #include <connections/connections.h>
+   *
+   *      int sc_main(int argc, char *argv[])
+   *      {
+   *      ...
+   *      Connections::analyze_backpressure("backpressure.csv");
+   *      sc_start();
+   *      ...
+   *      }
+   * \endcode
+   * \par
+   *
+   */
+  inline void analyze_backpressure(const std::string &path, int format = CHANNEL_STATS_CSV)
+  {
+    if (!get_conManager().backpressure) { get_conManager().backpressure = new backpressure_analyzer; }
+    new __backpressure_reporter(sc_gen_unique_name("backpressure_reporter"), path, format);
+  }
+#endif
+
+#ifdef CONNECTIONS_PROFILE
+  // Records one blocking Pop(), Peek() or Push() of the current process on port, from
+  // construction to destruction. vld_name and vld_suffix name the port in the report, see
+  // channel_base_name(). Does nothing unless report_connections_profile() was called.
+  class connections_profile_scope
+  {
+  public:
+    connections_profile_scope(const Blocking_abs *port, const char *vld_name, const char *vld_suffix)
+      : profiler(get_conManager().profiler), proc(0), info(0), port(port) {
+      if (!profiler) { return; }
+      sc_process_b *b = sc_core::sc_get_current_process_b();
+      if (!b) { return; }
+      connections_profiler::process_info &pi = profiler->processes[b];
+      if (pi.name.empty()) { pi.name = b->name(); }
+      info = &pi.ports[port];
+      if (info->name.empty()) { info->name = channel_base_name(vld_name, vld_suffix); }
+      proc = &pi;
+      enter = connections_profiler::host_clock::now();
+      // An interval in which the thread waited elsewhere, e.g. a plain wait(), also timed other
+      // processes: only count it if the delta cycle has not moved on since the last exit.
+      if (pi.has_exit) {
+        if (sc_delta_count() == pi.last_exit_delta) {
+          pi.host_compute += std::chrono::duration<double>(enter - pi.last_exit).count();
+        } else {
+          pi.skipped_intervals++;
+        }
+      }
+      enter_time = sc_time_stamp();
+    }
+
+    ~connections_profile_scope() {
+      if (!proc) { return; }
+      connections_profiler::host_clock::time_point now = connections_profiler::host_clock::now();
+      proc->host_blocked += std::chrono::duration<double>(now - enter).count();
+      proc->last_exit = now;
+      proc->last_exit_delta = sc_delta_count();
+      proc->has_exit = true;
+      info->calls++;
+      sc_time blocked = sc_time_stamp() - enter_time;
+      if (blocked == SC_ZERO_TIME) { return; }
+      info->blocked_calls++;
+      // Not get_sim_clk(), which insists on a clock: TLM_PORT channels may run without one.
+      std::vector<SimConnectionsClk::clk_info> &clks = ConManager_statics<void>::sim_clk.clk_info_vector;
+      if (port->clock_number < (int)clks.size() && clks[port->clock_number].period_delay != SC_ZERO_TIME) {
+        info->blocked_cycles += (unsigned long long)(blocked / clks[port->clock_number].period_delay + 0.5);
+      }
+    }
+
+  private:
+    connections_profiler *profiler;
+    connections_profiler::process_info *proc;
+    connections_profiler::port_info *info;
+    const Blocking_abs *port;
+    connections_profiler::host_clock::time_point enter;
+    sc_time enter_time;
+  };
+
+  class __connections_profile_reporter : public sc_module
+  {
+  public:
+    __connections_profile_reporter(sc_module_name name, const std::string &path, int format)
+      : sc_module(name), path(path), format(format) {}
+
+    void end_of_simulation() {
+      std::ofstream ofs(path.c_str());
+      if (!ofs.is_open()) {
+        SC_REPORT_WARNING("CONNECTIONS-501", ("Cannot open profile file '" + path + "'").c_str());
+        return;
+      }
+      get_conManager().profiler->write(ofs, format);
+    }
+
+  private:
+    std::string path;
+    int format;
+  };
+
+  /**
+   * \brief Profile how long each process computes and how long it is blocked in Connections calls.
+   * \ingroup Connections
+   *
+   * Only available when CONNECTIONS_PROFILE is defined, the hooks compile out otherwise.
+   * Every blocking Pop(), Peek() and Push() on MARSHALL_PORT, DIRECT_PORT and TLM_PORT
+   * ports and channels is timed on the host clock and in simulated time. The report has,
+   * per SC_THREAD:
+   *   - host_compute_s: host seconds from leaving one blocking call to entering the next,
+   *     i.e. the time the thread spends computing. Intervals in which the thread also waited
+   *     outside Connections calls, e.g. in a plain wait(), are excluded, as they include
+   *     other processes;
+   *   - host_blocked_s: host seconds inside blocking calls, mostly spent running other
+   *     processes;
+   *   - skipped_intervals: number of intervals excluded from host_compute_s;
+   *   - per port, ranked by blocked cycles: calls, calls that had to wait and the clock
+   *     cycles spent waiting.
+   *
+   * Must be called before sc_start(); the report is written from end_of_simulation().
+   *
+   * \par A Simple Example
+   * \code
+   *      #define CONNECTIONS_PROFILE
+   *      #include <connections/connections.h>
+   *
+   *      int sc_main(int argc, char *argv[])
+   *      {
+   *      ...
+   *      Connections::report_connections_profile("profile.csv");
+   *      sc_start();
+   *      ...
+   *      }
+   * \endcode
+   * \par
+   *
+   */
+  inline void report_connections_profile(const std::string &path, int format = CHANNEL_STATS_CSV)
+  {
+    if (!get_conManager().profiler) { get_conManager().profiler = new connections_profiler; }
+    new __connections_profile_reporter(sc_gen_unique_name("connections_profile_reporter"), path, format);
+  }
+
+#define CONNECTIONS_PROFILE_SCOPE(port, vld_name, vld_suffix) \
+  connections_profile_scope __connections_profile_scope(port, vld_name, vld_suffix)
+#else
+#define CONNECTIONS_PROFILE_SCOPE(port, vld_name, vld_suffix)
+#endif
+
 #ifdef __CONN_RAND_STALL_FEATURE
 
 #ifdef CONN_RAND_STALL
@@ -1340,6 +2093,32 @@ namespace Connections
 
 #endif //CONNECTIONS_SIM_ONLY
 
+  /**
+   * \brief Bit vector type carried by marshalled port signals
+   * \ingroup Connections
+   *
+   * \par Overview
+   * Marshalled ports and channels carry messages as sc_lv bits. In simulation only builds
+   * (CONNECTIONS_ACCURATE_SIM or CONNECTIONS_FAST_SIM), defining CONNECTIONS_MARSHALL_2STATE
+   * makes MARSHALL_PORT signals, and the converters between DIRECT_PORT and MARSHALL_PORT,
+   * use 2-state sc_bv instead. sc_bv stores half the bits of sc_lv, which makes signal
+   * updates and value-change comparisons of wide messages cheaper. SYN_PORT always uses
+   * sc_lv, so MARSHALL_PORT <-> SYN_PORT bindings (e.g. RTL co-simulation wrappers) are
+   * not available with CONNECTIONS_MARSHALL_2STATE.
+   *
+   */
+  template <unsigned int W, connections_port_t port_marshall_type>
+  struct marshalled_bits {
+    typedef sc_lv<W> type;
+  };
+
+#if defined(CONNECTIONS_MARSHALL_2STATE) && defined(CONNECTIONS_SIM_ONLY)
+  template <unsigned int W>
+  struct marshalled_bits<W, MARSHALL_PORT> {
+    typedef sc_bv<W> type;
+  };
+#endif
+
 //------------------------------------------------------------------------
 // InBlocking MARSHALL_PORT
 //------------------------------------------------------------------------
@@ -1347,12 +2126,12 @@ namespace Connections
 // For safety, disallow DIRECT_PORT <-> MARSHALL_PORT binding helpers during HLS.
 #ifndef __SYNTHESIS__
 
-  template <typename Message>
+  template <typename Message, connections_port_t port_marshall_type = MARSHALL_PORT>
   SC_MODULE(MarshalledToDirectOutPort)
   {
     typedef Wrapped<Message> WMessage;
     static const unsigned int width = WMessage::width;
-    typedef sc_lv<WMessage::width> MsgBits;
+    typedef typename marshalled_bits<WMessage::width, port_marshall_type>::type MsgBits;
     sc_signal<MsgBits> msgbits;
     sc_out<Message> _DATNAME_;
     sc_in<bool> _VLDNAME_;
@@ -1363,9 +2142,18 @@ namespace Connections
         sibling_port->sibling_port traversal in check_registration fully works
     **/
 #endif
+    // Bits of the last decoded message. Only decode when the message is valid and
+    // the bits differ from the last decoded ones, since _DATNAME_ then already holds
+    // the decoded value.
+    MsgBits last_bits;
+    bool last_bits_valid;
+
     void do_marshalled2direct() {
       if (_VLDNAME_) {
-        MsgBits mbits = msgbits.read();
+        const MsgBits &mbits = msgbits.read();
+        if (last_bits_valid && (mbits == last_bits)) { return; }
+        last_bits = mbits;
+        last_bits_valid = true;
         Marshaller<WMessage::width> marshaller(mbits);
         WMessage result;
         result.Marshall(marshaller);
@@ -1373,19 +2161,19 @@ namespace Connections
       }
     }
 
-    SC_CTOR(MarshalledToDirectOutPort) {
+    SC_CTOR(MarshalledToDirectOutPort) : last_bits_valid(false) {
       SC_METHOD(do_marshalled2direct);
       sensitive << msgbits;
       sensitive << _VLDNAME_;
     }
   };
 
-  template <typename Message>
+  template <typename Message, connections_port_t port_marshall_type = MARSHALL_PORT>
   SC_MODULE(MarshalledToDirectInPort)
   {
     typedef Wrapped<Message> WMessage;
     static const unsigned int width = WMessage::width;
-    typedef sc_lv<WMessage::width> MsgBits;
+    typedef typename marshalled_bits<WMessage::width, port_marshall_type>::type MsgBits;
     sc_in<MsgBits> msgbits;
     sc_in<bool> _VLDNAME_;
     sc_signal<Message> _DATNAME_;
@@ -1396,9 +2184,18 @@ namespace Connections
         sibling_port->sibling_port traversal in check_registration fully works
     **/
 #endif
+    // Bits of the last decoded message. Only decode when the message is valid and
+    // the bits differ from the last decoded ones, since _DATNAME_ then already holds
+    // the decoded value.
+    MsgBits last_bits;
+    bool last_bits_valid;
+
     void do_marshalled2direct() {
       if (_VLDNAME_) {
-        MsgBits mbits = msgbits.read();
+        const MsgBits &mbits = msgbits.read();
+        if (last_bits_valid && (mbits == last_bits)) { return; }
+        last_bits = mbits;
+        last_bits_valid = true;
         Marshaller<WMessage::width> marshaller(mbits);
         WMessage result;
         result.Marshall(marshaller);
@@ -1406,19 +2203,19 @@ namespace Connections
       }
     }
 
-    SC_CTOR(MarshalledToDirectInPort) {
+    SC_CTOR(MarshalledToDirectInPort) : last_bits_valid(false) {
       SC_METHOD(do_marshalled2direct);
       sensitive << msgbits;
       sensitive << _VLDNAME_;
     }
   };
 
-  template <typename Message>
+  template <typename Message, connections_port_t port_marshall_type = MARSHALL_PORT>
   SC_MODULE(DirectToMarshalledInPort)
   {
     typedef Wrapped<Message> WMessage;
     static const unsigned int width = WMessage::width;
-    typedef sc_lv<WMessage::width> MsgBits;
+    typedef typename marshalled_bits<WMessage::width, port_marshall_type>::type MsgBits;
     sc_in<Message> _DATNAME_;
     sc_signal<MsgBits> msgbits;
 #ifdef CONNECTIONS_SIM_ONLY
@@ -1443,12 +2240,12 @@ namespace Connections
     }
   };
 
-  template <typename Message>
+  template <typename Message, connections_port_t port_marshall_type = MARSHALL_PORT>
   SC_MODULE(DirectToMarshalledOutPort)
   {
     typedef Wrapped<Message> WMessage;
     static const unsigned int width = WMessage::width;
-    typedef sc_lv<WMessage::width> MsgBits;
+    typedef typename marshalled_bits<WMessage::width, port_marshall_type>::type MsgBits;
     sc_signal<Message> _DATNAME_;
     sc_out<MsgBits> msgbits;
 #ifdef CONNECTIONS_SIM_ONLY
@@ -1980,6 +2777,9 @@ namespace Connections
 // Peek
 #pragma design modulario < in >
     Message Peek() {
+#ifdef CONNECTIONS_SIM_ONLY
+      CONNECTIONS_PROFILE_SCOPE(this, this->_VLDNAME_.name(), _VLDNAMESTR_);
+#endif
       return InBlocking_Ports_abs<Message>::Peek();
     }
 
@@ -2244,6 +3044,13 @@ namespace Connections
 
     std::string full_name() { return "InBlockingSimPorts_abs"; }
 
+#ifdef CONNECTIONS_CHANNEL_STATS
+    std::string stats_name() { return channel_base_name(this->_VLDNAME_.name(), _VLDNAMESTR_); }
+    const char *stats_kind() { return "in"; }
+    const sc_object *stats_signal(bool out_side) { return dynamic_cast<const sc_object *>(this->_VLDNAME_.get_interface()); }
+    const sc_object *stats_module() { return this->_VLDNAME_.get_parent_object(); }
+#endif
+
     void Init_SIM(const char *name) {
       data_val = false;
       rdy_set_by_api = false;
@@ -2300,6 +3107,9 @@ namespace Connections
     }
 
     bool Pre() {
+#ifdef CONNECTIONS_CHANNEL_STATS
+      this->stats.sample(this->_VLDNAME_.read(), rdy_set_by_api);
+#endif
 #ifdef __CONN_RAND_STALL_FEATURE
       if ((local_rand_stall_override ? local_rand_stall_enable : get_rand_stall_enable()) && pacer_stall) {
         ++rand_stall_counter;
@@ -2379,6 +3189,7 @@ namespace Connections
     }
 
     Message &Pop_SIM() {
+      CONNECTIONS_PROFILE_SCOPE(this, this->_VLDNAME_.name(), _VLDNAMESTR_);
       while (Empty_SIM()) {
         wait();
       }
@@ -2512,9 +3323,9 @@ namespace Connections
 // Be safe: disallow DIRECT_PORT <-> SYN_PORT binding during HLS
 #ifndef __SYNTHESIS__
     void Bind(InBlocking<Message, DIRECT_PORT> &rhs) {
-      DirectToMarshalledInPort<Message> *dynamic_d2mport;
+      DirectToMarshalledInPort<Message, SYN_PORT> *dynamic_d2mport;
 
-      dynamic_d2mport = new DirectToMarshalledInPort<Message>(sc_gen_unique_name("dynamic_d2mport"));
+      dynamic_d2mport = new DirectToMarshalledInPort<Message, SYN_PORT>(sc_gen_unique_name("dynamic_d2mport"));
       this->sc_mod_alloc.push_back(dynamic_d2mport);
       dynamic_d2mport->_DATNAME_(rhs._DATNAME_);
       this->_DATNAME_(dynamic_d2mport->msgbits);
@@ -2530,9 +3341,9 @@ namespace Connections
     }
 
     void Bind(Combinational<Message, DIRECT_PORT> &rhs) {
-      DirectToMarshalledInPort<Message> *dynamic_d2mport;
+      DirectToMarshalledInPort<Message, SYN_PORT> *dynamic_d2mport;
 
-      dynamic_d2mport = new DirectToMarshalledInPort<Message>(sc_gen_unique_name("dynamic_d2mport"));
+      dynamic_d2mport = new DirectToMarshalledInPort<Message, SYN_PORT>(sc_gen_unique_name("dynamic_d2mport"));
       this->sc_mod_alloc.push_back(dynamic_d2mport);
       this->_DATNAME_(dynamic_d2mport->msgbits);
 
@@ -2615,7 +3426,7 @@ namespace Connections
     // Interface
     typedef Wrapped<Message> WMessage;
     static const unsigned int width = WMessage::width;
-    typedef sc_lv<WMessage::width> MsgBits;
+    typedef typename marshalled_bits<WMessage::width, MARSHALL_PORT>::type MsgBits;
     sc_in<MsgBits> _DATNAME_;
 
 #ifdef CONNECTIONS_SIM_ONLY
@@ -2623,7 +3434,9 @@ namespace Connections
 #endif
 
     InBlocking() : InBlocking_SimPorts_abs<Message>(),
-      _DATNAME_(sc_gen_unique_name(_DATNAMEINSTR_)) {}
+      _DATNAME_(sc_gen_unique_name(_DATNAMEINSTR_)) {
+      CONNECTIONS_MARSHALL_WIDTH_CHECK(Message);
+    }
 
     explicit InBlocking(const char *name) :
       InBlocking_SimPorts_abs<Message>(name)
@@ -2631,7 +3444,9 @@ namespace Connections
 #ifdef CONNECTIONS_SIM_ONLY
       , marker(CONNECTIONS_CONCAT(name, "in_port_marker"), width, &(this->_VLDNAME_), &(this->_RDYNAME_), &_DATNAME_)
 #endif
-    {}
+    {
+      CONNECTIONS_MARSHALL_WIDTH_CHECK(Message);
+    }
 
     virtual ~InBlocking() {}
 
@@ -2943,6 +3758,7 @@ namespace Connections
 #ifdef CONNECTIONS_ACCURATE_SIM
       get_sim_clk().check_on_clock_edge(this->clock_number);
 #endif
+      CONNECTIONS_PROFILE_SCOPE(this, i_fifo.name(), "i_fifo");
 #ifdef __CONN_RAND_STALL_FEATURE
       while ((local_rand_stall_override ? local_rand_stall_enable : get_rand_stall_enable()) && post_pacer->tic()) { wait(); }
 #endif
@@ -2956,6 +3772,7 @@ namespace Connections
 #ifdef CONNECTIONS_ACCURATE_SIM
       get_sim_clk().check_on_clock_edge(this->clock_number);
 #endif
+      CONNECTIONS_PROFILE_SCOPE(this, i_fifo.name(), "i_fifo");
       return i_fifo->peek();
     }
 
@@ -2986,6 +3803,7 @@ namespace Connections
     // Bind to Combinational
     void Bind(Combinational<Message, TLM_PORT> &rhs) {
       this->i_fifo(rhs.fifo);
+      rhs.out_str = rhs.port_vld_name(this->i_fifo.name(), "i_fifo");
     }
 
     template <typename C>
@@ -3380,6 +4198,9 @@ namespace Connections
       this->disable_spawn_true = 1;
     }
 
+    // Set on the driving port of a channel traced by channel_trace_events.
+    channel_trace_track *trace_track{0};
+
   protected:
     bool data_val;
     Message data_buf;
@@ -3393,6 +4214,13 @@ namespace Connections
 
     std::string full_name() { return "Out_Blocking_SimPorts_abs"; }
 
+#ifdef CONNECTIONS_CHANNEL_STATS
+    std::string stats_name() { return channel_base_name(this->_VLDNAME_.name(), _VLDNAMESTR_); }
+    const char *stats_kind() { return "out"; }
+    const sc_object *stats_signal(bool out_side) { return dynamic_cast<const sc_object *>(this->_VLDNAME_.get_interface()); }
+    const sc_object *stats_module() { return this->_VLDNAME_.get_parent_object(); }
+#endif
+
     void Reset_SIM() {
       this->reset_msg();
       data_val = false;
@@ -3426,8 +4254,13 @@ namespace Connections
     }
 
     bool Pre() {
+#ifdef CONNECTIONS_CHANNEL_STATS
+      this->stats.sample(val_set_by_api, transmitted());
+      this->stats_stalled = val_set_by_api && !transmitted();
+#endif
       if (data_val) {
         if (transmitted()) {
+          if (trace_track && !trace_track->buffered()) { trace_track->pop(); }
           data_val = false;
         }
       }
@@ -3436,6 +4269,7 @@ namespace Connections
 
     bool PrePostReset() {
       data_val = false;
+      if (trace_track) { trace_track->clear(); }
       return true;
     }
 
@@ -3443,6 +4277,9 @@ namespace Connections
       if (val_set_by_api != this->_VLDNAME_.read()) {
         // something has changed the value of the signal not through API
         // killing spawned threads;
+#ifdef CONNECTIONS_CHANNEL_STATS
+        this->stats_stalled = false;
+#endif
         return false;
       }
       transmit_val(data_val);
@@ -3454,6 +4291,7 @@ namespace Connections
       data_val = true;
       transmit_data(m);
       data_buf = m;
+      if (trace_track) { trace_track->push(); }
     }
 
     bool Empty_SIM() { return !data_val; }
@@ -3461,6 +4299,7 @@ namespace Connections
     bool Full_SIM() { return data_val; }
 
     void Push_SIM(const Message &m) {
+      CONNECTIONS_PROFILE_SCOPE(this, this->_VLDNAME_.name(), _VLDNAMESTR_);
       while (Full_SIM()) {
         wait();
       }
@@ -3557,8 +4396,8 @@ namespace Connections
     // For safety disallow DIRECT_PORT <-> SYN_PORT binding during HLS
 #ifndef __SYNTHESIS__
     void Bind(OutBlocking<Message, DIRECT_PORT> &rhs) {
-      MarshalledToDirectOutPort<Message> *dynamic_m2dport;
-      dynamic_m2dport = new MarshalledToDirectOutPort<Message>(sc_gen_unique_name("dynamic_m2dport"));
+      MarshalledToDirectOutPort<Message, SYN_PORT> *dynamic_m2dport;
+      dynamic_m2dport = new MarshalledToDirectOutPort<Message, SYN_PORT>(sc_gen_unique_name("dynamic_m2dport"));
       this->sc_mod_alloc.push_back(dynamic_m2dport);
 
 #ifdef CONNECTIONS_SIM_ONLY
@@ -3575,9 +4414,9 @@ namespace Connections
     }
 
     void Bind(Combinational<Message, DIRECT_PORT> &rhs) {
-      MarshalledToDirectOutPort<Message> *dynamic_m2dport;
+      MarshalledToDirectOutPort<Message, SYN_PORT> *dynamic_m2dport;
 
-      dynamic_m2dport = new MarshalledToDirectOutPort<Message>(sc_gen_unique_name("dynamic_m2dport"));
+      dynamic_m2dport = new MarshalledToDirectOutPort<Message, SYN_PORT>(sc_gen_unique_name("dynamic_m2dport"));
       this->sc_mod_alloc.push_back(dynamic_m2dport);
       this->_DATNAME_(dynamic_m2dport->msgbits);
 
@@ -3678,7 +4517,7 @@ namespace Connections
     // Interface
     typedef Wrapped<Message> WMessage;
     static const unsigned int width = WMessage::width;
-    typedef sc_lv<WMessage::width> MsgBits;
+    typedef typename marshalled_bits<WMessage::width, MARSHALL_PORT>::type MsgBits;
     sc_out<MsgBits> _DATNAME_;
 #ifdef CONNECTIONS_SIM_ONLY
     out_port_marker marker;
@@ -3690,8 +4529,11 @@ namespace Connections
 #ifdef CONNECTIONS_SIM_ONLY
       , driver(0)
       , log_stream(0)
+      , log_binary(0)
 #endif
-    {}
+    {
+      CONNECTIONS_MARSHALL_WIDTH_CHECK(Message);
+    }
 
     explicit OutBlocking(const char *name)
       : OutBlocking_SimPorts_abs<Message>(name)
@@ -3700,8 +4542,11 @@ namespace Connections
       , marker(CONNECTIONS_CONCAT(name, "out_port_marker"), width, &(this->_VLDNAME_), &(this->_RDYNAME_), &_DATNAME_)
       , driver(0)
       , log_stream(0)
+      , log_binary(0)
 #endif
-    {}
+    {
+      CONNECTIONS_MARSHALL_WIDTH_CHECK(Message);
+    }
 
     virtual ~OutBlocking() {} 
 
@@ -3834,12 +4679,12 @@ namespace Connections
     }
 
 #ifdef CONNECTIONS_SIM_ONLY
-    Message traced_msg;
+    std::unique_ptr<Message> traced_msg; // only allocated once the port is traced, see set_trace()
 #endif
 
     void write_msg(const Message &m) {
 #ifdef CONNECTIONS_SIM_ONLY
-      traced_msg = m;
+      if (traced_msg) { *traced_msg = m; }
 #endif
       Marshaller<WMessage::width> marshaller;
       WMessage wm(m);
@@ -3848,8 +4693,12 @@ namespace Connections
       _DATNAME_.write(bits);
 
 #ifdef CONNECTIONS_SIM_ONLY
-      if (log_stream)
-      { *log_stream << std::dec << log_number << " | " << std::hex <<  m << " | " << sc_time_stamp() << "\n"; }
+      if ((log_stream || log_binary) && log_sampler.sample()) {
+        if (log_stream)
+        { *log_stream << std::dec << log_number << " | " << std::hex <<  m << " | " << sc_time_stamp() << "\n"; }
+        if (log_binary)
+        { log_binary->record_bits(log_number, bits); }
+      }
 #endif
     }
 
@@ -3866,7 +4715,14 @@ namespace Connections
   public:
 #ifdef CONNECTIONS_SIM_ONLY
     void set_trace(sc_trace_file *trace_file_ptr, std::string full_name) {
-      sc_trace(trace_file_ptr, traced_msg, full_name);
+      // When tracing payloads as bits, trace the marshalled bits on the data signal: no copy
+      // and one trace entry per channel.
+      if (sc_trace_payload_bits()) {
+        sc_trace(trace_file_ptr, _DATNAME_, full_name);
+        return;
+      }
+      if (!traced_msg) { traced_msg.reset(new Message); }
+      sc_trace(trace_file_ptr, *traced_msg, full_name);
 
       if (this->disable_spawn_true) {
         sc_spawn_options opt;
@@ -3878,16 +4734,28 @@ namespace Connections
     }
 
     void trace_convert() {
-      traced_msg = convert_from_lv<Message>(_DATNAME_.read());
+      *traced_msg = convert_from_lv<Message>(_DATNAME_.read());
     }
 
     std::ofstream *log_stream;
+    channel_log_binary *log_binary;
     int log_number;
 
     void set_log(int num, std::ofstream *fp) {
       log_stream = fp;
       log_number = num;
     }
+
+    void set_log_binary(int num, channel_log_binary *log) {
+      log_binary = log;
+      log_number = num;
+    }
+
+    channel_log_sampler log_sampler;
+
+    void set_log_sampling(const channel_log_sampling *sampling) {
+      log_sampler.set(sampling);
+    }
 #endif
   };
 
@@ -4013,17 +4881,21 @@ namespace Connections
     }
 
 #ifdef CONNECTIONS_SIM_ONLY
-    Message traced_msg;
+    std::unique_ptr<sc_lv<Wrapped<Message>::width> > traced_bits; // only allocated when traced as bits, see set_trace()
 #endif
 
     void write_msg(const Message &m) {
 #ifdef CONNECTIONS_SIM_ONLY
-      traced_msg = m;
+      if (traced_bits) { *traced_bits = convert_to_lv(m); }
 #endif
       _DATNAME_.write(m);
 #ifdef CONNECTIONS_SIM_ONLY
-      if (log_stream)
-      { *log_stream << std::dec << log_number << " | " << std::hex <<  m << " | " << sc_time_stamp() << "\n"; }
+      if ((log_stream || log_binary) && log_sampler.sample()) {
+        if (log_stream)
+        { *log_stream << std::dec << log_number << " | " << std::hex <<  m << " | " << sc_time_stamp() << "\n"; }
+        if (log_binary)
+        { log_binary->record_bits(log_number, convert_to_lv(m)); }
+      }
 #endif
 
     }
@@ -4037,28 +4909,35 @@ namespace Connections
   public:
 #ifdef CONNECTIONS_SIM_ONLY
     void set_trace(sc_trace_file *trace_file_ptr, std::string full_name) {
-      sc_trace(trace_file_ptr, traced_msg, full_name);
-
-      if (this->disable_spawn_true) {
-        sc_spawn_options opt;
-        opt.spawn_method();
-        opt.set_sensitivity(&(_DATNAME_.value_changed()));
-        opt.dont_initialize();
-        sc_spawn(sc_bind(&OutBlocking<Message, DIRECT_PORT>::trace_convert, this), 0, &opt);
+      // The data signal already holds the message, trace it in place. Only tracing payloads
+      // as bits needs a copy, converted on write, so it needs writes through this port.
+      if (this->disable_spawn_true || !sc_trace_payload_bits()) {
+        sc_trace(trace_file_ptr, _DATNAME_, full_name);
+        return;
       }
-    }
-
-    void trace_convert() {
-      traced_msg = _DATNAME_.read();
+      if (!traced_bits) { traced_bits.reset(new sc_lv<Wrapped<Message>::width>); }
+      sc_trace(trace_file_ptr, *traced_bits, full_name);
     }
 
     std::ofstream *log_stream{0};
+    channel_log_binary *log_binary{0};
     int log_number{0};
 
     void set_log(int num, std::ofstream *fp) {
       log_stream = fp;
       log_number = num;
     }
+
+    void set_log_binary(int num, channel_log_binary *log) {
+      log_binary = log;
+      log_number = num;
+    }
+
+    channel_log_sampler log_sampler;
+
+    void set_log_sampling(const channel_log_sampling *sampling) {
+      log_sampler.set(sampling);
+    }
 #endif
   };
 
@@ -4106,6 +4985,7 @@ namespace Connections
 #ifdef CONNECTIONS_ACCURATE_SIM
       get_sim_clk().check_on_clock_edge(this->clock_number);
 #endif
+      CONNECTIONS_PROFILE_SCOPE(this, o_fifo.name(), "o_fifo");
       o_fifo->put(m);
       write_log->write_log(m);
       wait(sc_core::SC_ZERO_TIME);
@@ -4134,6 +5014,8 @@ namespace Connections
     void Bind(Combinational<Message, TLM_PORT> &rhs) {
       this->o_fifo(rhs.fifo);
       this->write_log(rhs);
+      rhs.fifo.clock_source = this;
+      rhs.in_str = rhs.port_vld_name(this->o_fifo.name(), "o_fifo");
     }
 
     // Binding
@@ -4239,12 +5121,97 @@ namespace Connections
 //------------------------------------------------------------------------
 
 #ifdef CONNECTIONS_SIM_ONLY
+  // Combinational output handshake and data signals are written by the spawned do_bypass()
+  // method while latency is 0, and by ConManager Pre()/Post() otherwise. Since reannotate()
+  // can switch between the two during simulation, the signals allow more than one writer.
+#define CONNECTIONS_BA_WRITER_POLICY SC_UNCHECKED_WRITERS
+
+  // Width in bits of a message type, for bandwidth annotation. Uses the static width of
+  // Marshall()able types, else length() (sc_int, sc_bv, ...), else the size of the type, so
+  // that DIRECT_PORT and TLM_PORT messages don't need a Wrapped<> specialization.
+  template <typename T>
+  inline auto ba_message_width(int) -> decltype(T::width, 0u) { return T::width; }
+
+  template <typename T>
+  inline auto ba_message_width(long) -> decltype(std::declval<T>().length(), 0u) { return T().length(); }
+
+  template <typename T>
+  inline unsigned int ba_message_width(...) { return std::is_same<T, bool>::value ? 1 : 8 * sizeof(T); }
+
+  // Ring of the messages in flight in a back-annotated channel. Ready cycles are kept in a
+  // separate dense array so the per-cycle ready check doesn't touch message storage, and
+  // messages are received straight into their slot instead of being copied in.
   template <typename Message>
-  class BA_Message
+  class BA_Buffer
   {
   public:
-    Message m;
-    unsigned long ready_cycle;
+    BA_Buffer() : head(0), tail(0), count(0) { resize(1); }
+
+    // Change the number of slots, keeping the messages in flight in order.
+    void resize(unsigned int new_size) {
+      assert(new_size >= count);
+      std::vector<Message> new_msgs(new_size);
+      std::vector<unsigned long> new_ready(new_size);
+#ifdef CONNECTIONS_CHANNEL_STATS
+      std::vector<unsigned long> new_pushed(new_size);
+#endif
+      for (unsigned int i = 0; i < count; i++) {
+        new_msgs[i] = msgs[head];
+        new_ready[i] = ready[head];
+#ifdef CONNECTIONS_CHANNEL_STATS
+        new_pushed[i] = pushed[head];
+#endif
+        head = next(head);
+      }
+      msgs.swap(new_msgs);
+      ready.swap(new_ready);
+#ifdef CONNECTIONS_CHANNEL_STATS
+      pushed.swap(new_pushed);
+#endif
+      head = 0;
+      tail = (count == new_size) ? 0 : count;
+    }
+
+    unsigned int size() const { return msgs.size(); }
+    unsigned int used() const { return count; }
+    bool is_empty() const { return count == 0; }
+    bool is_full() const { return count == msgs.size(); }
+
+    // Slot for the next message, committed by push().
+    Message &back() { return msgs[tail]; }
+
+    // push_cycle is only kept for latency histograms.
+    void push(unsigned long ready_cycle, unsigned long push_cycle) {
+      ready[tail] = ready_cycle;
+#ifdef CONNECTIONS_CHANNEL_STATS
+      pushed[tail] = push_cycle;
+#endif
+      tail = next(tail);
+      count++;
+    }
+
+    const Message &front() const { return msgs[head]; }
+    unsigned long front_ready_cycle() const { return ready[head]; }
+#ifdef CONNECTIONS_CHANNEL_STATS
+    unsigned long front_push_cycle() const { return pushed[head]; }
+#endif
+
+    void pop() {
+      head = next(head);
+      count--;
+    }
+
+    void clear() { head = tail = count = 0; }
+
+  private:
+    std::vector<Message> msgs;
+    std::vector<unsigned long> ready;
+#ifdef CONNECTIONS_CHANNEL_STATS
+    std::vector<unsigned long> pushed;
+#endif
+    unsigned int head, tail, count;
+
+    unsigned int next(unsigned int i) const { return (i + 1 == msgs.size()) ? 0 : i + 1; }
   };
 
   class Connections_BA_abs : public sc_module
@@ -4261,6 +5228,24 @@ namespace Connections
       CONNECTIONS_ASSERT_MSG(0, "Unreachable virtual function in abstract class!");
     }
 
+    // Annotate with an initiation interval as well: the channel accepts at most one message
+    // every interval clock cycles. Channels that can't model it only accept an interval of 1.
+    virtual void annotate(unsigned long latency, unsigned int capacity, unsigned int interval) {
+      CONNECTIONS_ASSERT_MSG(interval <= 1, "Channel does not support interval annotation!");
+      annotate(latency, capacity);
+    }
+
+    // Change latency, capacity and interval during simulation, taking effect delay_cycles clock
+    // cycles from now. Before simulation starts this is the same as annotate().
+    virtual void reannotate(unsigned long latency, unsigned int capacity, unsigned long delay_cycles = 0, unsigned int interval = 1) {
+      CONNECTIONS_ASSERT_MSG(0, "Unreachable virtual function in abstract class!");
+    }
+
+    // Width in bits of the messages carried, used to turn a bandwidth into an interval.
+    virtual unsigned int message_width() {
+      return 0;
+    }
+
     void disable_annotate() {
       CONNECTIONS_ASSERT_MSG(0, "Unreachable virtual function in abstract class!");
     }
@@ -4563,6 +5548,8 @@ namespace Connections
 
       , current_cycle(0)
       , latency(0)
+      , interval(1), next_accept_cycle(0)
+      , reannotate_pending(false), pending_latency(0), pending_capacity(0), pending_cycle(0), pending_interval(1)
 
       , out_bound(false), in_bound(false)
       , in_str(0), out_str(0)
@@ -4592,6 +5579,8 @@ namespace Connections
 
       , current_cycle(0)
       , latency(0)
+      , interval(1), next_accept_cycle(0)
+      , reannotate_pending(false), pending_latency(0), pending_capacity(0), pending_cycle(0), pending_interval(1)
 
       , out_bound(false), in_bound(false)
       , in_str(0), out_str(0)
@@ -4607,19 +5596,43 @@ namespace Connections
 
     std::string full_name() { return "Combinational_SimPorts_abs"; }
 
+#ifdef CONNECTIONS_CHANNEL_STATS
+    std::string stats_name() { return channel_base_name(_VLDNAMEIN_.name(), _COMBVLDNAMEINSTR_); }
+    const char *stats_kind() { return "channel"; }
+    const sc_object *stats_signal(bool out_side) {
+      if (out_side) { return &_VLDNAMEOUT_; }
+      return &_VLDNAMEIN_;
+    }
+#endif
+
   public:
     virtual ~Combinational_SimPorts_abs() {}
 
 #ifdef CONNECTIONS_SIM_ONLY
     //sc_signal<MsgBits> in_msg;
     sc_signal<bool>     _VLDNAMEIN_;
-    sc_signal<bool>     _RDYNAMEIN_;
+    sc_signal<bool, CONNECTIONS_BA_WRITER_POLICY> _RDYNAMEIN_;
     //sc_signal<MsgBits> out_msg;
-    sc_signal<bool>    _VLDNAMEOUT_;
+    sc_signal<bool, CONNECTIONS_BA_WRITER_POLICY> _VLDNAMEOUT_;
     sc_signal<bool>    _RDYNAMEOUT_;
     unsigned long current_cycle;
     unsigned long latency;
-    tlm::circular_buffer< BA_Message<Message> > b;
+    BA_Buffer<Message> b;
+    unsigned int interval;            // accept at most one message every interval cycles
+    unsigned long next_accept_cycle;
+
+    // Pending reannotate(), applied by Post() from pending_cycle on.
+    bool reannotate_pending;
+    unsigned long pending_latency;
+    unsigned int pending_capacity;
+    unsigned long pending_cycle;
+    unsigned int pending_interval;
+    sc_event bypass_event; // wakes do_bypass() when switching to latency 0
+    channel_trace_track *trace_track{0}; // see channel_trace_events
+#ifdef CONNECTIONS_CHANNEL_STATS
+    latency_histogram *latency_hist{0};
+    bool latency_hist_checked{0};
+#endif
 #endif
 
     // Reset
@@ -4751,10 +5764,6 @@ namespace Connections
     // Empty
 //  bool Empty() { return !val.read(); }
 
-#ifdef CONNECTIONS_SIM_ONLY
-    Message traced_msg;
-#endif
-
 // Push
 #pragma design modulario < out >
     void Push(const Message &m) {
@@ -4769,7 +5778,6 @@ namespace Connections
 #ifdef CONNECTIONS_ACCURATE_SIM
       get_sim_clk().check_on_clock_edge(this->clock_number);
 #endif
-      traced_msg = m;
 
       sim_out.Push(m);
 #else
@@ -4815,9 +5823,15 @@ namespace Connections
     }
 
     void annotate(unsigned long latency, unsigned int capacity) {
+      annotate(latency, capacity, 1);
+    }
+
+    void annotate(unsigned long latency, unsigned int capacity, unsigned int interval) {
       this->latency = latency;
       assert(! (latency == 0 && capacity > 0)); // latency == 0 && capacity > 0 is not supported.
       assert(! (latency > 0 && capacity == 0)); // latency > 0 but capacity == 0 is not supported.
+      assert(! (latency == 0 && interval > 1)); // interval > 1 requires latency > 0.
+      this->interval = (interval > 0) ? interval : 1;
       if (capacity > 0) {
         this->b.resize(capacity);
       } else {
@@ -4827,10 +5841,40 @@ namespace Connections
       this->sibling_port = in_ptr;
     }
 
+    void reannotate(unsigned long latency, unsigned int capacity, unsigned long delay_cycles = 0, unsigned int interval = 1) {
+      assert(! (latency == 0 && capacity > 0)); // latency == 0 && capacity > 0 is not supported.
+      assert(! (latency > 0 && capacity == 0)); // latency > 0 but capacity == 0 is not supported.
+      assert(! (latency == 0 && interval > 1)); // interval > 1 requires latency > 0.
+
+      if (sc_get_status() & (SC_ELABORATION | SC_BEFORE_END_OF_ELABORATION | SC_END_OF_ELABORATION | SC_START_OF_SIMULATION)) {
+        annotate(latency, capacity, interval);
+        return;
+      }
+
+      reannotate_pending = false;
+      if (latency == 0 && is_bypass()) { return; } // Nothing in flight, nothing to change.
+
+      pending_latency = latency;
+      pending_capacity = capacity;
+      pending_cycle = current_cycle + delay_cycles;
+      pending_interval = (interval > 0) ? interval : 1;
+      reannotate_pending = true;
+
+      // A bypass channel is not in ConManager's Pre()/Post() sweep, (re)register it.
+      // current_cycle stood still meanwhile, which is fine since pending_cycle and
+      // ready cycles are only compared relative to it.
+      this->sibling_port = in_ptr;
+      Connections::get_conManager().add_clock_late(this);
+    }
+
     void disable_annotate() {
       Connections::get_conManager().remove_annotate(this);
     }
 
+    unsigned int message_width() {
+      return ba_message_width<Message>(0);
+    }
+
     const char *src_name() {
       if (in_str) {
         return in_str;
@@ -4901,10 +5945,11 @@ namespace Connections
 
     void Reset_SIM() {
       current_cycle = 0;
+      next_accept_cycle = 0;
 
       data_val = false;
 
-      while (! b.is_empty()) { b.read(); }
+      b.clear();
     }
 
 // Although this code is being used only for simulation now, it could be
@@ -4973,7 +6018,10 @@ namespace Connections
     }
 
     bool Pre() {
-      if (is_bypass()) { return true; } // TODO: return false to deregister.
+      // A bypass channel is a wire driven by do_bypass(), drop it from ConManager's
+      // Pre()/Post() sweep. reannotate() registers it again through add_clock_late(),
+      // and it stays registered while that is pending.
+      if (is_bypass()) { return reannotate_pending; }
 
       // Input
       if (rdy_set_by_api != _RDYNAMEIN_.read()) {
@@ -4982,21 +6030,32 @@ namespace Connections
         return false;
       }
 
-      if (!b.is_full()) {
-        Message m;
-        if (received(m)) {
-          BA_Message<Message> bam;
-          bam.m = m;
+#ifdef CONNECTIONS_CHANNEL_STATS
+      // Input side of the channel, and how full it was over the cycle.
+      this->stats.sample(_VLDNAMEIN_.read(), rdy_set_by_api);
+      this->stats.sample_occupancy(b.used(), b.size());
+      if (!latency_hist_checked) {
+        latency_hist = get_conManager().get_latency_histogram(stats_name());
+        latency_hist_checked = true;
+      }
+#endif
+
+      if (rdy_set_by_api && !b.is_full()) {
+        if (received(b.back())) {
           assert(latency > 0);
-          bam.ready_cycle = current_cycle + latency;
-          b.write(bam);
+          b.push(current_cycle + latency, current_cycle);
+          next_accept_cycle = current_cycle + interval;
         }
       }
 
       // Output
       if (!b.is_empty()) {
         if (transmitted() && val_set_by_api) {
-          b.read(); // pop
+#ifdef CONNECTIONS_CHANNEL_STATS
+          if (latency_hist) { latency_hist->add(current_cycle - b.front_push_cycle()); }
+#endif
+          if (trace_track) { trace_track->pop(); }
+          b.pop();
         }
       }
       return true;
@@ -5006,7 +6065,9 @@ namespace Connections
       data_val = false;
 
       current_cycle = 0;
-      while (! b.is_empty()) { b.read(); }
+      next_accept_cycle = 0;
+      b.clear();
+      if (trace_track) { trace_track->clear(); }
 
       return true;
     }
@@ -5014,10 +6075,15 @@ namespace Connections
     bool Post() {
       current_cycle++; // Increment to next cycle.
 
-      if (is_bypass()) { return true; } // TODO: return false to deregister.
+      bool draining = false;
+      if (reannotate_pending && (current_cycle >= pending_cycle)) {
+        draining = ! apply_reannotate();
+      }
+
+      if (is_bypass()) { return reannotate_pending; } // Deregister, see Pre().
 
       // Input
-      receive(b.is_full());
+      receive(b.is_full() || draining || (current_cycle < next_accept_cycle));
 
       // Output
       if (val_set_by_api != _VLDNAMEOUT_.read()) {
@@ -5025,21 +6091,41 @@ namespace Connections
         // killing spawned threads;
         return false;
       }
-      if (! b.is_empty() && (b.read_data().ready_cycle <= current_cycle)) {
+      if (! b.is_empty() && (b.front_ready_cycle() <= current_cycle)) {
         transmit_val(true);
-        transmit_data(b.read_data().m); // peek
+        transmit_data(b.front()); // peek
       } else {
         transmit_val(false);
       }
       return true;
     }
 
+    // Apply a pending reannotate(). Returns false, leaving it pending, while the buffer
+    // holds more messages than the new capacity allows; Post() stalls the input until then.
+    bool apply_reannotate() {
+      if ((pending_latency == 0) ? !b.is_empty() : (b.used() > pending_capacity)) { return false; }
+
+      bool was_bypass = is_bypass();
+      latency = pending_latency;
+      interval = pending_interval;
+      unsigned int size = (pending_capacity > 0) ? pending_capacity : 1;
+      if (b.size() != size) { b.resize(size); } // Messages in flight keep their ready_cycle.
+      reannotate_pending = false;
+
+      if (is_bypass()) {
+        bypass_event.notify(SC_ZERO_TIME);
+      } else if (was_bypass) {
+        // Signals were last written by do_bypass(), take them over.
+        rdy_set_by_api = _RDYNAMEIN_.read();
+        val_set_by_api = _VLDNAMEOUT_.read();
+      }
+      return true;
+    }
+
     void FillBuf_SIM(const Message &m) {
-      BA_Message<Message> bam;
-      bam.m = m;
-      bam.ready_cycle = current_cycle + latency;
       assert(! b.is_full());
-      b.write(bam);
+      b.back() = m;
+      b.push(current_cycle + latency, current_cycle);
     }
 
     bool Empty_SIM() {
@@ -5192,10 +6278,10 @@ namespace Connections
     // Interface
     typedef Wrapped<Message> WMessage;
     static const unsigned int width = WMessage::width;
-    typedef sc_lv<WMessage::width> MsgBits;
+    typedef typename marshalled_bits<WMessage::width, MARSHALL_PORT>::type MsgBits;
 #ifdef CONNECTIONS_SIM_ONLY
     sc_signal<MsgBits> _DATNAMEIN_;
-    sc_signal<MsgBits> _DATNAMEOUT_;
+    sc_signal<MsgBits, CONNECTIONS_BA_WRITER_POLICY> _DATNAMEOUT_;
     OutBlocking<Message, MARSHALL_PORT> *driver;
 #else
     sc_signal<MsgBits> _DATNAME_;
@@ -5210,6 +6296,7 @@ namespace Connections
       ,_DATNAME_(sc_gen_unique_name(_COMBDATNAMESTR_))
 #endif
     {
+      CONNECTIONS_MARSHALL_WIDTH_CHECK(Message);
 #ifdef CONNECTIONS_SIM_ONLY
       driver = 0;
 
@@ -5221,6 +6308,7 @@ namespace Connections
         opt.set_sensitivity(&(this->_DATNAMEIN_.default_event()));
         opt.set_sensitivity(&(this->_VLDNAMEIN_.default_event()));
         opt.set_sensitivity(&(this->_RDYNAMEOUT_.default_event()));
+        opt.set_sensitivity(&(this->bypass_event));
         opt.dont_initialize();
         sc_spawn(sc_bind(&Combinational<Message, MARSHALL_PORT>::do_bypass, this), 0, &opt);
       }
@@ -5238,6 +6326,7 @@ namespace Connections
       ,_DATNAME_(CONNECTIONS_CONCAT(name, _DATNAMESTR_))
 #endif
     {
+      CONNECTIONS_MARSHALL_WIDTH_CHECK(Message);
 #ifdef CONNECTIONS_SIM_ONLY
       driver = 0;
 
@@ -5249,6 +6338,7 @@ namespace Connections
         opt.set_sensitivity(&(this->_DATNAMEIN_.default_event()));
         opt.set_sensitivity(&(this->_VLDNAMEIN_.default_event()));
         opt.set_sensitivity(&(this->_RDYNAMEOUT_.default_event()));
+        opt.set_sensitivity(&(this->bypass_event));
         opt.dont_initialize();
         sc_spawn(sc_bind(&Combinational<Message, MARSHALL_PORT>::do_bypass, this), 0, &opt);
       }
@@ -5419,6 +6509,45 @@ namespace Connections
         }
       }
 
+      bool set_log_binary(channel_log_binary *log, int &log_num, std::string &path_name) {
+        if (!parent.driver) {
+          OutBlocking<Message, MARSHALL_PORT> *driver = &(parent.sim_out);
+
+          path_name = parent.name();
+          driver->set_log_binary(++log_num, log);
+          return true;
+        } else {
+          OutBlocking<Message, MARSHALL_PORT> *driver = parent.driver;
+          while (driver->driver)
+          { driver = driver->driver; }
+
+          path_name = parent._DATNAMEOUT_.name();
+          driver->set_log_binary(++log_num, log);
+          return true;
+        }
+      }
+
+      void set_log_sampling(const channel_log_sampling *sampling) {
+        OutBlocking<Message, MARSHALL_PORT> *driver = parent.driver ? parent.driver : &(parent.sim_out);
+        while (driver->driver)
+        { driver = driver->driver; }
+        driver->set_log_sampling(sampling);
+      }
+
+      bool trace_events_name(std::string &name) {
+        name = channel_base_name(parent._VLDNAMEIN_.name(), _COMBVLDNAMEINSTR_);
+        return true;
+      }
+
+      void set_trace_events(channel_trace_track *track) {
+        OutBlocking<Message, MARSHALL_PORT> *driver = parent.driver ? parent.driver : &(parent.sim_out);
+        while (driver->driver)
+        { driver = driver->driver; }
+        driver->trace_track = track;
+        parent.trace_track = track;
+        track->set_buffer_latency(&parent.latency);
+      }
+
     } dummyPortManager;
 #endif
   };
@@ -5435,7 +6564,7 @@ namespace Connections
     // Interface
 #ifdef CONNECTIONS_SIM_ONLY
     dbg_signal<Message> _DATNAMEIN_;
-    dbg_signal<Message> _DATNAMEOUT_;
+    dbg_signal<Message, void, CONNECTIONS_BA_WRITER_POLICY> _DATNAMEOUT_;
     OutBlocking<Message, DIRECT_PORT> *driver{0};  // DGB
 #else
 #ifdef __SYNTHESIS__
@@ -5463,6 +6592,7 @@ namespace Connections
         opt.set_sensitivity(&(this->_DATNAMEIN_.default_event()));
         opt.set_sensitivity(&(this->_VLDNAMEIN_.default_event()));
         opt.set_sensitivity(&(this->_RDYNAMEOUT_.default_event()));
+        opt.set_sensitivity(&(this->bypass_event));
         opt.dont_initialize();
         sc_spawn(sc_bind(&Combinational<Message, DIRECT_PORT>::do_bypass, this), 0, &opt);
       }
@@ -5487,6 +6617,7 @@ namespace Connections
         opt.set_sensitivity(&(this->_DATNAMEIN_.default_event()));
         opt.set_sensitivity(&(this->_VLDNAMEIN_.default_event()));
         opt.set_sensitivity(&(this->_RDYNAMEOUT_.default_event()));
+        opt.set_sensitivity(&(this->bypass_event));
         opt.dont_initialize();
         sc_spawn(sc_bind(&Combinational<Message, DIRECT_PORT>::do_bypass, this), 0, &opt);
       }
@@ -5646,12 +6777,197 @@ namespace Connections
         }
       }
 
+      bool set_log_binary(channel_log_binary *log, int &log_num, std::string &path_name) {
+        if (!parent.driver) {
+          OutBlocking<Message, DIRECT_PORT> *driver = &(parent.sim_out);
+
+          path_name = parent.name();
+          driver->set_log_binary(++log_num, log);
+          return true;
+        } else {
+          OutBlocking<Message, DIRECT_PORT> *driver = parent.driver;
+          while (driver->driver)
+          { driver = driver->driver; }
+
+          path_name = parent._DATNAMEOUT_.name();
+          driver->set_log_binary(++log_num, log);
+          return true;
+        }
+      }
+
+      void set_log_sampling(const channel_log_sampling *sampling) {
+        OutBlocking<Message, DIRECT_PORT> *driver = parent.driver ? parent.driver : &(parent.sim_out);
+        while (driver->driver)
+        { driver = driver->driver; }
+        driver->set_log_sampling(sampling);
+      }
+
+      bool trace_events_name(std::string &name) {
+        name = channel_base_name(parent._VLDNAMEIN_.name(), _COMBVLDNAMEINSTR_);
+        return true;
+      }
+
+      void set_trace_events(channel_trace_track *track) {
+        OutBlocking<Message, DIRECT_PORT> *driver = parent.driver ? parent.driver : &(parent.sim_out);
+        while (driver->driver)
+        { driver = driver->driver; }
+        driver->trace_track = track;
+        parent.trace_track = track;
+        track->set_buffer_latency(&parent.latency);
+      }
+
     } dummyPortManager;
 #endif
   };
 
 
 #ifdef CONNECTIONS_SIM_ONLY
+  // tlm_fifo of a back-annotated Combinational<Message,TLM_PORT>. Every message carries the
+  // time from which it can be read, latency clock cycles after it was written, so the fifo
+  // acts as a delay line of at most size() messages. Writes are spaced at least interval
+  // clock cycles apart.
+  template <typename Message>
+  class BA_tlm_fifo : public tlm::tlm_fifo<Message>
+  {
+  public:
+    typedef tlm::tlm_fifo<Message> base;
+
+    BA_tlm_fifo(const char *name, int size)
+      : base(name, size), clock_source(0), trace_track(0), latency(0), interval(1), pending(false) {}
+
+    // Blocking_abs whose clock latency is counted in, normally the driving Out port.
+    Blocking_abs *clock_source;
+
+    // Set when the channel is traced by channel_trace_events.
+    channel_trace_track *trace_track;
+
+    void annotate(unsigned long latency, unsigned int capacity, unsigned int interval = 1) {
+      assert(! (latency == 0 && capacity > 0)); // latency == 0 && capacity > 0 is not supported.
+      assert(! (latency > 0 && capacity == 0)); // latency > 0 but capacity == 0 is not supported.
+      assert(! (latency == 0 && interval > 1)); // interval > 1 requires latency > 0.
+      this->latency = latency;
+      this->interval = (interval > 0) ? interval : 1;
+      if (capacity > 0) { base::nb_bound(capacity); }
+    }
+
+    void reannotate(unsigned long latency, unsigned int capacity, unsigned long delay_cycles, unsigned int interval) {
+      assert(! (latency == 0 && capacity > 0)); // latency == 0 && capacity > 0 is not supported.
+      assert(! (latency > 0 && capacity == 0)); // latency > 0 but capacity == 0 is not supported.
+      assert(! (latency == 0 && interval > 1)); // interval > 1 requires latency > 0.
+      pending = true;
+      pending_latency = latency;
+      pending_capacity = capacity;
+      pending_interval = (interval > 0) ? interval : 1;
+      pending_time = sc_time_stamp() + (double)delay_cycles * period();
+    }
+
+    // Drop all messages, including those not ready yet.
+    void clear() {
+      Message m;
+      while (base::nb_get(m)) { ready.pop_front(); }
+      if (trace_track) { trace_track->clear(); }
+    }
+
+    // tlm get interface
+    Message get(tlm::tlm_tag<Message> *t = 0) {
+      wait_ready();
+      ready.pop_front();
+      Message m = base::get(t);
+      if (trace_track) { trace_track->pop(); }
+      return m;
+    }
+
+    bool nb_get(Message &m) {
+      if (! nb_can_get()) { return false; }
+      ready.pop_front();
+      if (trace_track) { trace_track->pop(); }
+      return base::nb_get(m);
+    }
+
+    bool nb_can_get(tlm::tlm_tag<Message> *t = 0) const {
+      return base::nb_can_get(t) && (ready.front() <= sc_time_stamp());
+    }
+
+    // tlm peek interface
+    Message peek(tlm::tlm_tag<Message> *t = 0) const {
+      wait_ready();
+      return base::peek(t);
+    }
+
+    using base::nb_peek;
+    bool nb_peek(Message &m) const {
+      if (! nb_can_peek()) { return false; }
+      return base::nb_peek(m);
+    }
+
+    bool nb_can_peek(tlm::tlm_tag<Message> *t = 0) const {
+      return base::nb_can_peek(t) && (ready.front() <= sc_time_stamp());
+    }
+
+    // tlm put interface
+    void put(const Message &m) {
+      apply_pending();
+      sc_time now = sc_time_stamp();
+      if (next_put > now) { sc_core::wait(next_put - now); }
+      base::put(m);
+      written();
+    }
+
+    bool nb_put(const Message &m) {
+      apply_pending();
+      if (next_put > sc_time_stamp()) { return false; }
+      if (! base::nb_put(m)) { return false; }
+      written();
+      return true;
+    }
+
+    bool nb_can_put(tlm::tlm_tag<Message> *t = 0) const {
+      return base::nb_can_put(t) && (next_put <= sc_time_stamp());
+    }
+
+  protected:
+    unsigned long latency;
+    unsigned int interval;
+    std::deque<sc_time> ready; // one entry per message written and not yet read
+    sc_time next_put;          // earliest time of the next write
+
+    bool pending;
+    unsigned long pending_latency;
+    unsigned int pending_capacity;
+    unsigned int pending_interval;
+    sc_time pending_time;
+
+    void written() {
+      sc_time now = sc_time_stamp();
+      ready.push_back(now + (double)latency * period());
+      if (trace_track) { trace_track->push(); }
+      if (interval > 1) { next_put = now + (double)interval * period(); }
+    }
+
+    sc_time period() const {
+      if (latency == 0 && ! pending) { return SC_ZERO_TIME; }
+      CONNECTIONS_ASSERT_MSG(get_sim_clk().clk_info_vector.size() > 0, "Back-annotated TLM_PORT channel requires a clock");
+      int c = (clock_source && clock_source->clock_registered) ? clock_source->clock_number : 0;
+      return get_sim_clk().clk_info_vector[c].period_delay;
+    }
+
+    void wait_ready() const {
+      while (! base::nb_can_peek()) { sc_core::wait(base::ok_to_peek()); }
+      sc_time now = sc_time_stamp();
+      if (ready.front() > now) { sc_core::wait(ready.front() - now); }
+    }
+
+    // Apply a pending reannotate(). A lower capacity takes effect once the fifo has
+    // drained below it, messages in flight keep their ready time.
+    void apply_pending() {
+      if (! pending || sc_time_stamp() < pending_time) { return; }
+      latency = pending_latency;
+      interval = pending_interval;
+      if (pending_capacity > 0 && ! base::nb_bound(pending_capacity)) { return; }
+      pending = false;
+    }
+  };
+
   template <typename Message>
   class Combinational <Message, TLM_PORT> :
     public Combinational_Ports_abs<Message>
@@ -5662,11 +6978,13 @@ namespace Connections
   public:
 
     Combinational() : Combinational_Ports_abs<Message>()
-      ,fifo(sc_gen_unique_name("fifo"), 2) {}
+      ,fifo(sc_gen_unique_name("fifo"), 2)
+      ,ba(sc_gen_unique_name("comb_ba"), *this) {}
 
 
     explicit Combinational(const char *name) : Combinational_Ports_abs<Message>(name)
-      ,fifo(CONNECTIONS_CONCAT(name, "fifo"), 1) {}
+      ,fifo(CONNECTIONS_CONCAT(name, "fifo"), 1)
+      ,ba(CONNECTIONS_CONCAT(name, "comb_BA"), *this) {}
 
     virtual ~Combinational() {}
 
@@ -5674,8 +6992,7 @@ namespace Connections
     void ResetRead() {
       this->read_reset_check.reset(false);
       get_conManager().add_clock_event(this);
-      Message temp;
-      while (fifo.nb_get(temp));
+      fifo.clear();
     }
 
     void ResetWrite() {
@@ -5704,6 +7021,7 @@ namespace Connections
 #ifdef CONNECTIONS_ACCURATE_SIM
       get_sim_clk().check_on_clock_edge(this->clock_number);
 #endif
+      CONNECTIONS_PROFILE_SCOPE(this, fifo.name(), "fifo");
       return fifo.get();
     }
 
@@ -5714,6 +7032,7 @@ namespace Connections
 #ifdef CONNECTIONS_ACCURATE_SIM
       get_sim_clk().check_on_clock_edge(this->clock_number);
 #endif
+      CONNECTIONS_PROFILE_SCOPE(this, fifo.name(), "fifo");
       return fifo.peek();
     }
 
@@ -5738,6 +7057,7 @@ namespace Connections
 #ifdef CONNECTIONS_ACCURATE_SIM
       get_sim_clk().check_on_clock_edge(this->clock_number);
 #endif
+      CONNECTIONS_PROFILE_SCOPE(this, fifo.name(), "fifo");
       fifo.put(m);
       write_log(m);
     }
@@ -5765,12 +7085,38 @@ namespace Connections
      return 1;
     }
 
+    virtual bool set_log_binary(channel_log_binary *log, int &log_num, std::string &path_name) {
+     log_binary = log;
+     log_number = ++log_num;
+     path_name = fifo.name();
+     return 1;
+    }
+
+    virtual void set_log_sampling(const channel_log_sampling *sampling) {
+     log_sampler.set(sampling);
+    }
+
+    virtual bool trace_events_name(std::string &name) {
+     name = fifo.name();
+     return 1;
+    }
+
+    virtual void set_trace_events(channel_trace_track *track) {
+     fifo.trace_track = track;
+    }
+
     virtual void write_log(const Message& m) {
-      if (log_stream)
-       *log_stream << std::dec << log_number << " | " << std::hex <<  m << " | " << sc_time_stamp() << "\n"; 
+      if ((log_stream || log_binary) && log_sampler.sample()) {
+       if (log_stream)
+        *log_stream << std::dec << log_number << " | " << std::hex <<  m << " | " << sc_time_stamp() << "\n"; 
+       if (log_binary)
+        log_binary->record_bits(log_number, convert_to_lv(m));
+      }
     }
 
     std::ofstream *log_stream{0};
+    channel_log_binary *log_binary{0};
+    channel_log_sampler log_sampler;
     int log_number{0};
 
   protected:
@@ -5788,7 +7134,54 @@ namespace Connections
     }
 
   public:
-    tlm::tlm_fifo<Message> fifo;
+    BA_tlm_fifo<Message> fifo;
+
+    // Names of the bound Out and In ports, as in CONNECTIONS_ACCURATE_SIM
+    std::string in_str, out_str;
+
+    // Back-annotation of the channel, see annotate_design().
+    class CombinationalBA : public Connections_BA_abs
+    {
+    public:
+      CombinationalBA(const char *name, Combinational &parent_) : Connections_BA_abs(name), parent(parent_) {
+        Connections::get_conManager().add_annotate(this);
+      }
+
+      void annotate(unsigned long latency, unsigned int capacity) {
+        parent.fifo.annotate(latency, capacity);
+      }
+
+      void annotate(unsigned long latency, unsigned int capacity, unsigned int interval) {
+        parent.fifo.annotate(latency, capacity, interval);
+      }
+
+      void reannotate(unsigned long latency, unsigned int capacity, unsigned long delay_cycles = 0, unsigned int interval = 1) {
+        if (sc_get_status() & (SC_ELABORATION | SC_BEFORE_END_OF_ELABORATION | SC_END_OF_ELABORATION | SC_START_OF_SIMULATION)) {
+          parent.fifo.annotate(latency, capacity, interval);
+        } else {
+          parent.fifo.reannotate(latency, capacity, delay_cycles, interval);
+        }
+      }
+
+      unsigned int message_width() {
+        return ba_message_width<Message>(0);
+      }
+
+      const char *src_name() { return parent.in_str.empty() ? "UNBOUND" : parent.in_str.c_str(); }
+
+      const char *dest_name() { return parent.out_str.empty() ? "UNBOUND" : parent.out_str.c_str(); }
+
+    private:
+      Combinational &parent;
+    } ba;
+
+    // Port name as the CONNECTIONS_ACCURATE_SIM valid signal would have it.
+    static std::string port_vld_name(const char *fifo_port_name, const char *suffix) {
+      std::string nm(fifo_port_name);
+      std::size_t len = strlen(suffix);
+      if (nm.length() >= len && nm.compare(nm.length() - len, len, suffix) == 0) { nm.erase(nm.length() - len); }
+      return nm + _VLDNAMESTR_;
+    }
   };
 #endif // CONNECTIONS_SIM_ONLY
 
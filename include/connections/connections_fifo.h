@@ -66,7 +66,7 @@ namespace Connections
     // Interface
     typedef Wrapped<Message> WMessage;
     static const unsigned int width = WMessage::width;
-    typedef sc_lv<WMessage::width> MsgBits;
+    typedef typename marshalled_bits<WMessage::width, port_marshall_type>::type MsgBits;
     sc_signal<MsgBits> _DATNAME_;
     uint64 init_val{0};
 
@@ -117,6 +117,9 @@ namespace Connections
       , rst("rst")
       , enq(sc_gen_unique_name("enq"))
       , deq(sc_gen_unique_name("deq"))
+#ifdef CONNECTIONS_ACCURATE_SIM
+      , ba("fifo_BA", *this)
+#endif
     { 
       Init();
     }
@@ -127,10 +130,55 @@ namespace Connections
       , rst("rst")
       , enq(CONNECTIONS_CONCAT(name, "enq"))
       , deq(CONNECTIONS_CONCAT(name, "deq"))
+#ifdef CONNECTIONS_ACCURATE_SIM
+      , ba("fifo_BA", *this)
+#endif
     {
       Init();
     }
 
+#ifdef CONNECTIONS_ACCURATE_SIM
+    // Back-annotation of the Fifo, see annotate_design(). Latency is the number of cycles from
+    // enqueue until an entry can be dequeued (at least 1, the Fifo register). A nonzero
+    // capacity limits the number of entries below NumEntries.
+    class FifoBA : public Connections_BA_abs
+    {
+    public:
+      FifoBA(const char *name, Fifo &parent_) : Connections_BA_abs(name), parent(parent_) {
+        Connections::get_conManager().add_annotate(this);
+      }
+
+      void annotate(unsigned long latency, unsigned int capacity) {
+        CONNECTIONS_SIM_ONLY_ASSERT_MSG(capacity <= NumEntries, "Fifo capacity can't be annotated above NumEntries");
+        parent.ba_latency = latency;
+        parent.ba_capacity = capacity;
+        parent.ba_pending = false;
+      }
+
+      void reannotate(unsigned long latency, unsigned int capacity, unsigned long delay_cycles = 0, unsigned int interval = 1) {
+        CONNECTIONS_SIM_ONLY_ASSERT_MSG(interval <= 1, "Fifo does not support interval annotation");
+        if (sc_get_status() & (SC_ELABORATION | SC_BEFORE_END_OF_ELABORATION | SC_END_OF_ELABORATION | SC_START_OF_SIMULATION)) {
+          annotate(latency, capacity);
+          return;
+        }
+        CONNECTIONS_SIM_ONLY_ASSERT_MSG(capacity <= NumEntries, "Fifo capacity can't be annotated above NumEntries");
+        // Applied by Seq(). Entries already enqueued keep their ready cycle, and a lower
+        // capacity stalls enq until the Fifo has drained below it.
+        parent.ba_pending_latency = latency;
+        parent.ba_pending_capacity = capacity;
+        parent.ba_pending_cycle = parent.ba_cycle + delay_cycles;
+        parent.ba_pending = true;
+      }
+
+      const char *src_name() { return parent.enq._VLDNAME_.name(); }
+
+      const char *dest_name() { return parent.deq._VLDNAME_.name(); }
+
+    private:
+      Fifo &parent;
+    };
+#endif
+
   protected:
     typedef bool Bit;
     static const int AddrWidth = nbits<NumEntries>::val;
@@ -147,6 +195,26 @@ namespace Connections
     sc_signal<BuffIdx> tail;
     FifoElem<Message, port_marshall_type> buffer[NumEntries];
 
+#ifdef CONNECTIONS_ACCURATE_SIM
+    // Back-annotation state, simulation only
+    FifoBA ba;
+    unsigned long ba_latency{0};
+    unsigned int ba_capacity{0}; // 0: NumEntries
+    unsigned long ba_cycle{0};
+    unsigned long ba_ready[NumEntries]{}; // cycle from which each entry can be dequeued
+    unsigned long ba_ready_max{0};        // latest of ba_ready
+    sc_signal<Bit> ba_tail_ready;
+    bool ba_pending{0};
+    unsigned long ba_pending_latency{0};
+    unsigned int ba_pending_capacity{0};
+    unsigned long ba_pending_cycle{0};
+    sc_event ba_changed;
+#ifdef CONNECTIONS_CHANNEL_STATS
+    unsigned long ba_enq_cycle[NumEntries]{}; // cycle each entry was enqueued, for latency histograms
+    latency_histogram *ba_latency_hist{0};
+#endif
+#endif
+
     // Helper functions
     void Init() {
       #ifdef CONNECTIONS_SIM_ONLY
@@ -154,11 +222,20 @@ namespace Connections
       deq.disable_spawn();
       #endif
 
+      // Back-annotation only adds wake-ups when annotated: ba_tail_ready does not change
+      // without latency annotation, and Seq() notifies ba_changed every cycle only while a
+      // capacity limit makes CanEnq() depend on head and tail.
       SC_METHOD(EnqRdy);
       sensitive << full;
+      #ifdef CONNECTIONS_ACCURATE_SIM
+      sensitive << ba_changed;
+      #endif
 
       SC_METHOD(DeqVal);
       sensitive << full << head << tail;
+      #ifdef CONNECTIONS_ACCURATE_SIM
+      sensitive << ba_tail_ready;
+      #endif
 
       SC_METHOD(DeqMsg);
       #ifndef __SYNTHESIS__
@@ -172,12 +249,21 @@ namespace Connections
 
       SC_METHOD(HeadNext);
       sensitive << enq._VLDNAME_ << full << head;
+      #ifdef CONNECTIONS_ACCURATE_SIM
+      sensitive << ba_changed;
+      #endif
 
       SC_METHOD(TailNext);
       sensitive << deq._RDYNAME_ << full << head << tail;
+      #ifdef CONNECTIONS_ACCURATE_SIM
+      sensitive << ba_tail_ready;
+      #endif
 
       SC_METHOD(FullNext);
       sensitive << enq._VLDNAME_ << deq._RDYNAME_ << full << head << tail;
+      #ifdef CONNECTIONS_ACCURATE_SIM
+      sensitive << ba_tail_ready << ba_changed;
+      #endif
 
       SC_THREAD(Seq);
       sensitive << clk.pos();
@@ -189,13 +275,33 @@ namespace Connections
 
     // Combinational logic
 
+    // Room to enqueue
+    bool CanEnq() {
+    #ifdef CONNECTIONS_ACCURATE_SIM
+      if (ba_capacity > 0 && ba_capacity < NumEntries && !full.read()) {
+        unsigned int used = (head.read() + NumEntries - tail.read()) % NumEntries;
+        return (used < ba_capacity);
+      }
+    #endif
+      return !full.read();
+    }
+
+    // Entry to dequeue
+    bool CanDeq() {
+      bool empty = (!full.read() && (head.read() == tail.read()));
+    #ifdef CONNECTIONS_ACCURATE_SIM
+      return !empty && ba_tail_ready.read();
+    #else
+      return !empty;
+    #endif
+    }
+
     // Enqueue ready
-    void EnqRdy() { enq._RDYNAME_.write(!full.read()); }
+    void EnqRdy() { enq._RDYNAME_.write(CanEnq()); }
 
     // Dequeue valid
     void DeqVal() {
-      bool empty = (!full.read() && (head.read() == tail.read()));
-      deq._VLDNAME_.write(!empty);
+      deq._VLDNAME_.write(CanDeq());
     }
 
     // Dequeue message
@@ -215,7 +321,7 @@ namespace Connections
 
     // Head next calculations
     void HeadNext() {
-      bool do_enq = (enq._VLDNAME_.read() && !full.read());
+      bool do_enq = (enq._VLDNAME_.read() && CanEnq());
       BuffIdx head_inc;
       if ((head.read() + 1) == NumEntries)
       { head_inc = 0; }
@@ -230,8 +336,7 @@ namespace Connections
 
     // Tail next calculations
     void TailNext() {
-      bool empty = (!full.read() && (head.read() == tail.read()));
-      bool do_deq = (deq._RDYNAME_.read() && !empty);
+      bool do_deq = (deq._RDYNAME_.read() && CanDeq());
       BuffIdx tail_inc;
       if ((tail.read() + 1) == NumEntries)
       { tail_inc = 0; }
@@ -246,9 +351,8 @@ namespace Connections
 
     // Full next calculations
     void FullNext() {
-      bool empty = (!full.read() && (head.read() == tail.read()));
-      bool do_enq = (enq._VLDNAME_.read() && !full.read());
-      bool do_deq = (deq._RDYNAME_.read() && !empty);
+      bool do_enq = (enq._VLDNAME_.read() && CanEnq());
+      bool do_deq = (deq._RDYNAME_.read() && CanDeq());
 
       BuffIdx head_inc;
       if ((head.read() + 1) == NumEntries)
@@ -273,10 +377,34 @@ namespace Connections
       #pragma hls_unroll yes
       for (unsigned int i = 0; i < NumEntries; ++i)
       { buffer[i].reset_state(); }
+      #ifdef CONNECTIONS_ACCURATE_SIM
+      ba_cycle = 0;
+      ba_ready_max = 0;
+      ba_tail_ready.write(true);
+      #ifdef CONNECTIONS_CHANNEL_STATS
+      ba_latency_hist = get_conManager().get_latency_histogram(name());
+      #endif
+      #endif
 
       wait();
 
       while (1) {
+        #ifdef CONNECTIONS_ACCURATE_SIM
+        ba_cycle++;
+        if (ba_pending && (ba_cycle >= ba_pending_cycle)) {
+          ba.annotate(ba_pending_latency, ba_pending_capacity);
+          ba_changed.notify(SC_ZERO_TIME);
+        } else if (ba_capacity > 0 && ba_capacity < NumEntries) {
+          ba_changed.notify(SC_ZERO_TIME); // re-evaluate CanEnq() once head and tail are updated
+        }
+        #endif
+
+        #if defined(CONNECTIONS_ACCURATE_SIM) && defined(CONNECTIONS_CHANNEL_STATS)
+        if (ba_latency_hist && deq._RDYNAME_.read() && CanDeq()) {
+          ba_latency_hist->add(ba_cycle - ba_enq_cycle[tail.read()]);
+        }
+        #endif
+
         // Head update
         head.write(head_next);
 
@@ -287,9 +415,24 @@ namespace Connections
         full.write(full_next);
 
         // Enqueue message
-        if (enq._VLDNAME_.read() && !full.read()) {
+        if (enq._VLDNAME_.read() && CanEnq()) {
           buffer[head.read()]._DATNAME_.write(enq._DATNAME_.read());
+          #ifdef CONNECTIONS_ACCURATE_SIM
+          ba_ready[head.read()] = ba_cycle + ((ba_latency > 1) ? ba_latency - 1 : 0);
+          ba_ready_max = std::max(ba_ready_max, ba_ready[head.read()]);
+          #ifdef CONNECTIONS_CHANNEL_STATS
+          ba_enq_cycle[head.read()] = ba_cycle;
+          #endif
+          #endif
+        }
+
+        #ifdef CONNECTIONS_ACCURATE_SIM
+        // The tail entry can be dequeued once its ready cycle is reached. Without latency
+        // annotation, and no entry left from one, this is always the case: skip the write.
+        if (ba_latency > 1 || ba_ready_max > ba_cycle || !ba_tail_ready.read()) {
+          ba_tail_ready.write(ba_ready[tail_next.read()] <= ba_cycle);
         }
+        #endif
 
         wait();
       }
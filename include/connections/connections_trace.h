@@ -41,6 +41,23 @@
 #ifndef CONNECTIONS_TRACE_H
 #define CONNECTIONS_TRACE_H
 #include <systemc>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <regex>
+#ifdef CONNECTIONS_LOG_ZLIB
+#include <zlib.h>
+#endif
+#include "channel_log_reader.h"
 
 /**
  * Example of how to enable tracing for user defined structs:
@@ -58,15 +75,528 @@ struct MyType
 
 **/
 
+namespace Connections
+{
+  // Hierarchical name pattern, either a glob ('*' matches any run of characters including '.',
+  // '?' any one character) or an ECMAScript regex, matched against the full name. Used by
+  // channel_name_filter and the rules of annotate_design().
+  class channel_name_pattern
+  {
+  public:
+    channel_name_pattern() : is_regex(false) {}
+    channel_name_pattern(const std::string &pattern, bool is_regex = false) { assign(pattern, is_regex); }
+
+    void assign(const std::string &pattern, bool is_regex = false) {
+      this->pattern = pattern;
+      this->is_regex = is_regex;
+      if (is_regex) { re.assign(pattern, std::regex::ECMAScript | std::regex::optimize); }
+    }
+
+    const std::string &str() const { return pattern; }
+
+    bool match(const std::string &name) const {
+      if (is_regex) { return std::regex_match(name, re); }
+      return channel_name_glob_match(name.c_str(), pattern.c_str());
+    }
+
+  private:
+    std::string pattern;
+    bool is_regex;
+    std::regex re;
+  };
+
+  // Escape s for use inside a JSON string, for the names in the JSON reports and trace files.
+  inline std::string json_escape(const std::string &s)
+  {
+    std::string out;
+    out.reserve(s.length());
+    for (std::size_t i = 0; i < s.length(); i++) {
+      unsigned char c = s[i];
+      if (c == '"' || c == '\\') {
+        out += '\\';
+        out += c;
+      } else if (c < 0x20) {
+        char buf[8];
+        snprintf(buf, sizeof(buf), "\\u%04x", c);
+        out += buf;
+      } else {
+        out += c;
+      }
+    }
+    return out;
+  }
+
+  // Channel selection by hierarchical name, shared by channel_logs and channel_trace_events.
+  // A channel is selected if it matches any include pattern (or none were given) and no
+  // exclude pattern.
+  class channel_name_filter
+  {
+  public:
+    std::vector<channel_name_pattern> includes;
+    std::vector<channel_name_pattern> excludes;
+
+    void include( const std::string &pattern ) { includes.push_back(channel_name_pattern(pattern)); }
+    void include_regex( const std::string &re ) { includes.push_back(channel_name_pattern(re, true)); }
+    void exclude( const std::string &pattern ) { excludes.push_back(channel_name_pattern(pattern)); }
+    void exclude_regex( const std::string &re ) { excludes.push_back(channel_name_pattern(re, true)); }
+
+    bool selected( const std::string &name ) const {
+      bool included = includes.empty();
+      for ( unsigned i = 0; !included && i < includes.size(); i++ ) { included = includes[i].match(name); }
+      if ( !included ) { return false; }
+      for ( unsigned i = 0; i < excludes.size(); i++ ) {
+        if ( excludes[i].match(name) ) { return false; }
+      }
+      return true;
+    }
+  };
+}
+
 #ifdef CONNECTIONS_SIM_ONLY
 namespace Connections 
 {
+  // Sampling of logged transfers, see channel_logs::sample_every() and sample_window().
+  struct channel_log_sampling {
+    unsigned long every;            // log every Nth transfer within the window
+    sc_core::sc_time from, to;      // only log transfers in [from, to]
+
+    channel_log_sampling() : every(1), from(sc_core::SC_ZERO_TIME), to(sc_core::sc_max_time()) {}
+    bool all() const { return every <= 1 && from == sc_core::SC_ZERO_TIME && to == sc_core::sc_max_time(); }
+  };
+
+  // Per port sampling state. Ports without sampling keep cfg == 0 and log every transfer.
+  class channel_log_sampler
+  {
+  public:
+    channel_log_sampler() : cfg(0), count(0) {}
+
+    void set(const channel_log_sampling *cfg) {
+      this->cfg = cfg;
+      count = 0;
+    }
+
+    bool sample() {
+      if (!cfg) { return true; }
+      const sc_core::sc_time &now = sc_core::sc_time_stamp();
+      if (now < cfg->from || now > cfg->to) { return false; }
+      return (count++ % cfg->every) == 0;
+    }
+
+  private:
+    const channel_log_sampling *cfg;
+    unsigned long count;
+  };
+
+  // Binary channel log, see channel_logs::enable(). Records are queued by the simulation thread
+  // into a lock-free single producer, single consumer ring and written to the file by a
+  // background thread. SystemC runs all processes on one OS thread, so one ring per file is the
+  // per-thread buffer; record() must only be called from the simulation thread.
+  //
+  // Plain file layout, in host byte order:
+  //   header:  char magic[8] "CONNLOG1", uint64 time resolution in fs
+  //   record:  uint32 log_number, uint32 payload bytes, uint64 sc_time_stamp().value(), payload
+  // The payload holds the marshalled message bits, least significant byte first.
+  //
+  // Indexed file layout: the records are grouped in blocks of about block_bytes, each block
+  // compressed on its own with zlib if CONNECTIONS_LOG_ZLIB is defined (link with -lz), and
+  // an index at the end of the file lets readers skip blocks by time and channel:
+  //   header:  char magic[8] "CONNLOG2", uint64 time resolution in fs
+  //   blocks:  stored block data
+  //   index:   per block: uint64 file offset, uint32 stored bytes, uint32 raw bytes,
+  //            uint32 compression (0 stored raw, 1 zlib), uint64 first time, uint64 last time,
+  //            uint32 records, uint32 channels, uint32 log_number[channels] (sorted)
+  //   trailer: uint64 index offset, uint32 blocks, uint32 compression (0 none, 1 zlib),
+  //            char magic[8] "CONNIDX2"
+  // A block that zlib fails to compress is stored raw. Logs from before the per block flag end
+  // in "CONNIDX1" and have no per block field; the trailer applies to all their blocks.
+  //
+  // tools/channel_log_decode turns either file back into the text format.
+  class channel_log_binary
+  {
+  public:
+    channel_log_binary() : fp(0), indexed(false), block_bytes(0), mask(0), head(0), tail(0), stop(false) {}
+    ~channel_log_binary() { close(); }
+
+    bool open(const std::string &path, bool indexed = false, std::size_t block_bytes = 1 << 20,
+              std::size_t ring_bytes = 1 << 22) {
+      close();
+      fp = fopen(path.c_str(), "wb");
+      if (!fp) { return false; }
+      this->path = path;
+      open_logs().push_back(this);
+
+      std::size_t size = 1024;
+      while (size < ring_bytes) { size <<= 1; }
+      ring.assign(size, 0);
+      mask = size - 1;
+      head.store(0);
+      tail.store(0);
+      stop.store(false);
+
+      this->indexed = indexed;
+      this->block_bytes = block_bytes;
+      block.clear();
+      block_records = 0;
+      block_parsed = 0;
+      block_channels.clear();
+      index.clear();
+
+      unsigned long long resolution_fs = (unsigned long long)(sc_core::sc_get_time_resolution().to_seconds() * 1e15 + 0.5);
+      fwrite(indexed ? "CONNLOG2" : "CONNLOG1", 1, 8, fp);
+      fwrite(&resolution_fs, sizeof(resolution_fs), 1, fp);
+
+      writer.reset(new std::thread(&channel_log_binary::drain, this));
+      return true;
+    }
+
+    bool is_open() const { return fp != 0; }
+
+    // Write out everything queued so far and close the file.
+    void close() {
+      if (writer) {
+        stop.store(true, std::memory_order_release);
+        writer->join();
+        writer.reset();
+      }
+      if (fp) {
+        if (indexed) { write_index(); }
+        fclose(fp);
+        fp = 0;
+        open_logs().erase(std::find(open_logs().begin(), open_logs().end(), this));
+      }
+    }
+
+    // Close all open logs and keep them for reopen_closed(). Call before fork(): the child of
+    // a process with running writer threads must not start threads or use stdio itself.
+    static void close_for_fork() {
+      std::vector<channel_log_binary *> logs(open_logs());
+      for (std::size_t i = 0; i < logs.size(); i++) {
+        logs[i]->close();
+        closed_for_fork().push_back(logs[i]);
+      }
+    }
+
+    // Reopen the logs closed by close_for_fork(), each on its own path with suffix inserted
+    // before the extension, e.g. channel_logs_data_3.bin for suffix "_3", in the same format.
+    static void reopen_closed(const std::string &suffix) {
+      std::vector<channel_log_binary *> logs;
+      logs.swap(closed_for_fork());
+      for (std::size_t i = 0; i < logs.size(); i++) {
+        std::string p = logs[i]->path;
+        std::size_t dot = p.rfind('.');
+        std::size_t slash = p.find_last_of("/\\");
+        if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) { dot = p.length(); }
+        logs[i]->open(p.substr(0, dot) + suffix + p.substr(dot), logs[i]->indexed, logs[i]->block_bytes, logs[i]->ring.size());
+      }
+    }
+
+    static void close_all() {
+      std::vector<channel_log_binary *> logs(open_logs());
+      for (std::size_t i = 0; i < logs.size(); i++) { logs[i]->close(); }
+    }
+
+    void record(unsigned int log_number, const void *payload, unsigned int bytes) {
+      record_header hdr = { log_number, bytes, (unsigned long long)sc_core::sc_time_stamp().value() };
+      std::size_t total = sizeof(hdr) + bytes;
+      sc_assert(total <= ring.size());
+
+      std::size_t h = head.load(std::memory_order_relaxed);
+      while (ring.size() - (h - tail.load(std::memory_order_acquire)) < total) { std::this_thread::yield(); }
+      put(h, &hdr, sizeof(hdr));
+      put(h + sizeof(hdr), payload, bytes);
+      head.store(h + total, std::memory_order_release);
+    }
+
+    // Record a marshalled sc_lv or sc_bv.
+    template <typename Bits>
+    void record_bits(unsigned int log_number, const Bits &bits) {
+      unsigned int bytes = (bits.length() + 7) / 8;
+      scratch.resize((bytes + 3) & ~3u);
+      for (unsigned int w = 0; w < scratch.size() / 4; w++) {
+        sc_dt::sc_digit d = bits.get_word(w);
+        for (unsigned int i = 0; i < 4; i++) { scratch[4 * w + i] = (unsigned char)(d >> (8 * i)); }
+      }
+      record(log_number, scratch.data(), bytes);
+    }
+
+  private:
+    struct record_header {
+      unsigned int log_number;
+      unsigned int bytes;
+      unsigned long long time;
+    };
+
+    struct block_info {
+      unsigned long long offset;
+      unsigned int stored_bytes;
+      unsigned int raw_bytes;
+      unsigned int compressed;
+      unsigned long long first_time;
+      unsigned long long last_time;
+      unsigned int records;
+      std::vector<unsigned int> channels;
+    };
+
+    FILE *fp;
+    std::string path;
+    bool indexed;
+    std::size_t block_bytes;
+    std::vector<unsigned char> ring;
+    std::vector<unsigned char> scratch;
+    std::size_t mask;
+    std::atomic<std::size_t> head; // bytes queued, written by the simulation thread only
+    std::atomic<std::size_t> tail; // bytes written out, written by the writer thread only
+    std::atomic<bool> stop;
+    std::unique_ptr<std::thread> writer;
+
+    // Indexed mode, owned by the writer thread until close().
+    std::vector<unsigned char> block;
+    std::vector<unsigned char> stored;
+    std::size_t block_parsed;        // bytes of complete records at the front of block
+    unsigned int block_records;
+    unsigned long long block_first_time, block_last_time;
+    std::vector<unsigned int> block_channels;
+    std::vector<block_info> index;
+
+    static std::vector<channel_log_binary *> &open_logs() {
+      static std::vector<channel_log_binary *> logs;
+      return logs;
+    }
+
+    static std::vector<channel_log_binary *> &closed_for_fork() {
+      static std::vector<channel_log_binary *> logs;
+      return logs;
+    }
+
+    void put(std::size_t pos, const void *src, std::size_t n) {
+      std::size_t off = pos & mask;
+      std::size_t first = std::min(n, ring.size() - off);
+      memcpy(&ring[off], src, first);
+      if (n > first) { memcpy(&ring[0], (const unsigned char *)src + first, n - first); }
+    }
+
+    void drain() {
+      while (true) {
+        bool stopping = stop.load(std::memory_order_acquire);
+        std::size_t t = tail.load(std::memory_order_relaxed);
+        std::size_t h = head.load(std::memory_order_acquire);
+        if (h == t) {
+          if (stopping) { break; }
+          std::this_thread::sleep_for(std::chrono::microseconds(200));
+          continue;
+        }
+        std::size_t off = t & mask;
+        std::size_t n = h - t;
+        std::size_t first = std::min(n, ring.size() - off);
+        output(&ring[off], first);
+        if (n > first) { output(&ring[0], n - first); }
+        tail.store(h, std::memory_order_release);
+      }
+      if (indexed && block_parsed > 0) { write_block(); }
+      fflush(fp);
+    }
+
+    void output(const unsigned char *p, std::size_t n) {
+      if (!indexed) {
+        fwrite(p, 1, n, fp);
+        return;
+      }
+      // Collect whole records into the block, noting their times and channels.
+      block.insert(block.end(), p, p + n);
+      record_header hdr;
+      while (block.size() - block_parsed >= sizeof(hdr)) {
+        memcpy(&hdr, &block[block_parsed], sizeof(hdr));
+        if (block.size() - block_parsed < sizeof(hdr) + hdr.bytes) { break; }
+        if (block_records == 0) { block_first_time = hdr.time; }
+        block_last_time = hdr.time;
+        block_records++;
+        std::vector<unsigned int>::iterator c = std::lower_bound(block_channels.begin(), block_channels.end(), hdr.log_number);
+        if (c == block_channels.end() || *c != hdr.log_number) { block_channels.insert(c, hdr.log_number); }
+        block_parsed += sizeof(hdr) + hdr.bytes;
+        if (block_parsed >= block_bytes) { write_block(); }
+      }
+    }
+
+    void write_block() {
+      block_info bi;
+      bi.offset = channel_log_tell(fp);
+      bi.raw_bytes = (unsigned int)block_parsed;
+      bi.first_time = block_first_time;
+      bi.last_time = block_last_time;
+      bi.records = block_records;
+      bi.channels.swap(block_channels);
+      bi.compressed = 0;
+#ifdef CONNECTIONS_LOG_ZLIB
+      uLongf len = compressBound(block_parsed);
+      stored.resize(len);
+      if (compress2(&stored[0], &len, &block[0], block_parsed, 1) == Z_OK) {
+        fwrite(&stored[0], 1, len, fp);
+        bi.stored_bytes = (unsigned int)len;
+        bi.compressed = 1;
+      }
+#endif
+      if (!bi.compressed) {
+        fwrite(&block[0], 1, block_parsed, fp);
+        bi.stored_bytes = (unsigned int)block_parsed;
+      }
+      index.push_back(bi);
+
+      block.erase(block.begin(), block.begin() + block_parsed);
+      block_parsed = 0;
+      block_records = 0;
+      block_channels.clear();
+    }
+
+    void write_index() {
+      unsigned long long index_offset = channel_log_tell(fp);
+      for (std::size_t i = 0; i < index.size(); i++) {
+        const block_info &bi = index[i];
+        unsigned int channels = (unsigned int)bi.channels.size();
+        fwrite(&bi.offset, sizeof(bi.offset), 1, fp);
+        fwrite(&bi.stored_bytes, sizeof(bi.stored_bytes), 1, fp);
+        fwrite(&bi.raw_bytes, sizeof(bi.raw_bytes), 1, fp);
+        fwrite(&bi.compressed, sizeof(bi.compressed), 1, fp);
+        fwrite(&bi.first_time, sizeof(bi.first_time), 1, fp);
+        fwrite(&bi.last_time, sizeof(bi.last_time), 1, fp);
+        fwrite(&bi.records, sizeof(bi.records), 1, fp);
+        fwrite(&channels, sizeof(channels), 1, fp);
+        if (channels) { fwrite(&bi.channels[0], sizeof(unsigned int), channels, fp); }
+      }
+      unsigned int blocks = (unsigned int)index.size();
+#ifdef CONNECTIONS_LOG_ZLIB
+      unsigned int compression = 1;
+#else
+      unsigned int compression = 0;
+#endif
+      fwrite(&index_offset, sizeof(index_offset), 1, fp);
+      fwrite(&blocks, sizeof(blocks), 1, fp);
+      fwrite(&compression, sizeof(compression), 1, fp);
+      fwrite("CONNIDX2", 1, 8, fp);
+      index.clear();
+    }
+  };
+
+  // Chrome trace-event JSON file, see channel_trace_events. Events are collected in a buffer
+  // of about buffer_bytes and appended to the file whenever it fills up, so memory stays
+  // bounded however long the simulation runs. The file is a JSON array of events that
+  // close() terminates; viewers also load a file left unterminated by a crash.
+  class channel_trace_event_writer
+  {
+  public:
+    channel_trace_event_writer() : fp(0), limit(0), tracks(0) {}
+    ~channel_trace_event_writer() { close(); }
+
+    bool open(const std::string &path, std::size_t buffer_bytes = 1 << 20) {
+      close();
+      fp = fopen(path.c_str(), "w");
+      if (!fp) { return false; }
+      limit = buffer_bytes;
+      buf.reserve(limit + 256);
+      tracks = 0;
+      buf = "[\n";
+      return true;
+    }
+
+    bool is_open() const { return fp != 0; }
+
+    // New track (a trace-event thread), returns its id.
+    int add_track(const std::string &name) {
+      int tid = ++tracks;
+      std::ostringstream ss;
+      ss << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+         << ",\"args\":{\"name\":\"" << json_escape(name) << "\"}},\n"
+         << "{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+         << ",\"args\":{\"sort_index\":" << tid << "}},\n";
+      append(ss.str());
+      return tid;
+    }
+
+    // Complete event from begin to end on a track, times in us.
+    void slice(int tid, const sc_core::sc_time &begin, const sc_core::sc_time &end, unsigned long long seq) {
+      char line[192];
+      int n = snprintf(line, sizeof(line),
+                       "{\"name\":\"msg\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.6f,\"dur\":%.6f,\"args\":{\"seq\":%llu}},\n",
+                       tid, begin.to_seconds() * 1e6, (end - begin).to_seconds() * 1e6, seq);
+      if (n > 0) { append(line, (std::size_t)n); }
+    }
+
+    void flush() {
+      if (fp && !buf.empty()) {
+        fwrite(buf.data(), 1, buf.size(), fp);
+        buf.clear();
+      }
+    }
+
+    void close() {
+      if (!fp) { return; }
+      append("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Connections channels\"}}\n]\n");
+      flush();
+      fclose(fp);
+      fp = 0;
+    }
+
+  private:
+    FILE *fp;
+    std::string buf;
+    std::size_t limit;
+    int tracks;
+
+    void append(const std::string &s) { append(s.data(), s.size()); }
+    void append(const char *s, std::size_t n) {
+      if (!fp) { return; }
+      buf.append(s, n);
+      if (buf.size() >= limit) { flush(); }
+    }
+  };
+
+  // Messages in flight on one traced channel. The producer side calls push() when a message is
+  // pushed, the consumer side pop() when it leaves the channel, which writes the slice.
+  class channel_trace_track
+  {
+  public:
+    channel_trace_track(channel_trace_event_writer *w, int tid) : w(w), tid(tid), seq(0), buffer_latency(0) {}
+
+    // Latency of the channel's back-annotation buffer, if any. While it's nonzero, messages
+    // leave the channel from the buffer rather than at the producer's handshake.
+    void set_buffer_latency(const unsigned long *latency) { buffer_latency = latency; }
+    bool buffered() const { return buffer_latency && *buffer_latency; }
+
+    void push() { begin.push_back(sc_core::sc_time_stamp()); }
+
+    void pop() {
+      if (begin.empty()) { return; }
+      w->slice(tid, begin.front(), sc_core::sc_time_stamp(), seq++);
+      begin.pop_front();
+    }
+
+    void clear() { begin.clear(); }
+
+  private:
+    channel_trace_event_writer *w;
+    int tid;
+    unsigned long long seq;
+    const unsigned long *buffer_latency;
+    std::deque<sc_core::sc_time> begin;
+  };
+
+  // Set while trace_hierarchy_bits() runs: ports then trace their payload as one flat bit
+  // vector instead of one entry per message field.
+  inline bool &sc_trace_payload_bits()
+  {
+    static bool bits = false;
+    return bits;
+  }
+
   // Used to mark and select Connections Sync and Combinational channels for tracing
   class sc_trace_marker
   {
   public:
     virtual void set_trace(sc_trace_file *trace_file_ptr) = 0;
     virtual bool set_log(std::ofstream *os, int &log_num, std::string &path_name) = 0;
+    virtual bool set_log_binary(channel_log_binary *log, int &log_num, std::string &path_name) { return false; }
+    virtual void set_log_sampling(const channel_log_sampling *sampling) {}
+    virtual bool trace_events_name(std::string &name) { return false; }
+    virtual void set_trace_events(channel_trace_track *track) {}
   };
 }
 #endif
@@ -95,11 +625,37 @@ static inline void trace_hierarchy( sc_object *obj, sc_trace_file *file_ptr )
 #endif
 }
 
+// Function: trace_hierarchy_bits(sc_object* obj, sc_trace_file* file_ptr)
+//  Same as trace_hierarchy(), but traces each channel payload as a single bit vector of the
+//  marshalled message instead of sc_trace() of every field. For deeply nested message structs
+//  this keeps the trace file and the per timestep compare down to one entry per channel, and
+//  MARSHALL_PORT channels trace their data signal in place, without a copy of the message.
+//
+static inline void trace_hierarchy_bits( sc_object *obj, sc_trace_file *file_ptr )
+{
+#ifdef CONNECTIONS_SIM_ONLY
+  Connections::sc_trace_payload_bits() = true;
+  trace_hierarchy(obj, file_ptr);
+  Connections::sc_trace_payload_bits() = false;
+#endif
+}
+
 // Logging Connections channel data under a level of hierarchy.
 // Object names are by default in channel_logs_names.txt
 // Object values are by default in channel_logs_data.txt
 // Change the file names by supplying the base name to the enable() method.
 // Use the enable() method "unbuffered" arg to help debug when simulations hang or terminate abnormally.
+// Use the enable() method "format" arg to write a binary log instead, which is much faster for
+// large logs: CHANNEL_LOG_BINARY writes channel_logs_data.bin, CHANNEL_LOG_INDEXED writes
+// channel_logs_data.clog, a block compressed file with a time and channel index for reading back
+// one channel or time window without a full scan. Decode either with tools/channel_log_decode.
+//
+// To log only some channels, call include() and exclude() with glob patterns (or
+// include_regex() and exclude_regex()) before log_hierarchy(). They are matched against the
+// channel names written to channel_logs_names.txt. A channel is logged if it matches an include
+// pattern, or there are none, and matches no exclude pattern. Channels that are not selected are
+// never hooked up and cost nothing during simulation. sample_every() and sample_window() thin
+// out the transfers logged on the selected channels.
 //
 // Example usage in sc_main()
 //
@@ -107,10 +663,19 @@ static inline void trace_hierarchy( sc_object *obj, sc_trace_file *file_ptr )
 //
 //  channel_logs logs;
 //  logs.enable("log", true);
+//  logs.include("top.noc.*");
+//  logs.exclude("*.credit*");
+//  logs.sample_every(100);
 //  logs.log_hierarchy(top);
 //
 
-class channel_logs
+enum channel_log_format {
+  CHANNEL_LOG_TEXT    = 0,  // channel_logs_data.txt
+  CHANNEL_LOG_BINARY  = 1,  // channel_logs_data.bin
+  CHANNEL_LOG_INDEXED = 2   // channel_logs_data.clog
+};
+
+class channel_logs : public Connections::channel_name_filter
 {
 public:
   bool enabled{false};
@@ -118,22 +683,51 @@ public:
   int log_num{0};
   std::ofstream log_stream;
   std::ofstream log_names;
+#ifdef CONNECTIONS_SIM_ONLY
+  Connections::channel_log_binary log_binary;
+  Connections::channel_log_sampling sampling;
+#endif
 
   channel_logs() {}
 
-  int enable( std::string fname_base = "", bool unbuffered = false ) {
+  // Log only every Nth transfer of each channel.
+  void sample_every( unsigned long n ) {
+#ifdef CONNECTIONS_SIM_ONLY
+    sampling.every = (n > 0) ? n : 1;
+#endif
+  }
+
+  // Log only transfers between from and to, inclusive.
+  void sample_window( const sc_time &from, const sc_time &to ) {
+#ifdef CONNECTIONS_SIM_ONLY
+    sampling.from = from;
+    sampling.to = to;
+#endif
+  }
+
+  int enable( std::string fname_base = "", bool unbuffered = false, int format = CHANNEL_LOG_TEXT ) {
     if ( fname_base.empty() ) {
       fname_base = "channel_logs";
     }
     std::ostringstream nm_stream, nm_names;
-    nm_stream << fname_base << "_data.txt";
-    if ( unbuffered ) {
-      log_stream.rdbuf()->pubsetbuf(0, 0);
-    }
-    log_stream.open(nm_stream.str());
-    if ( !log_stream.is_open() ) {
-      std::cerr << "Cannot open file '" << nm_stream.str() << "'" << std::endl;
-      return 1;
+    if ( format != CHANNEL_LOG_TEXT ) {
+#ifdef CONNECTIONS_SIM_ONLY
+      nm_stream << fname_base << ((format == CHANNEL_LOG_INDEXED) ? "_data.clog" : "_data.bin");
+      if ( !log_binary.open(nm_stream.str(), format == CHANNEL_LOG_INDEXED) ) {
+        std::cerr << "Cannot open file '" << nm_stream.str() << "'" << std::endl;
+        return 1;
+      }
+#endif
+    } else {
+      nm_stream << fname_base << "_data.txt";
+      if ( unbuffered ) {
+        log_stream.rdbuf()->pubsetbuf(0, 0);
+      }
+      log_stream.open(nm_stream.str());
+      if ( !log_stream.is_open() ) {
+        std::cerr << "Cannot open file '" << nm_stream.str() << "'" << std::endl;
+        return 1;
+      }
     }
     nm_names << fname_base << "_names.txt";
     if ( unbuffered ) {
@@ -151,7 +745,20 @@ public:
 #ifdef CONNECTIONS_SIM_ONLY
     if ( Connections::sc_trace_marker *p = dynamic_cast<Connections::sc_trace_marker *>(obj) ) {
       std::string path_name;
-      if ( log_stream.is_open() && log_names.is_open() && p->set_log(&log_stream, log_num, path_name) ) {
+      int num = log_num;
+      bool binary = log_binary.is_open();
+      bool hooked = log_names.is_open() &&
+                    ( binary ? p->set_log_binary(&log_binary, num, path_name)
+                      : ( log_stream.is_open() && p->set_log(&log_stream, num, path_name) ) );
+      if ( hooked && !selected(path_name) ) {
+        // The channel's name is only known once it is hooked up, unhook it again.
+        int unused = num;
+        std::string unused_name;
+        if ( binary ) { p->set_log_binary(0, unused, unused_name); }
+        else { p->set_log(0, unused, unused_name); }
+      } else if ( hooked ) {
+        log_num = num;
+        if ( !sampling.all() ) { p->set_log_sampling(&sampling); }
         log_names << log_num << " " << path_name << "\n";
       }
     }
@@ -171,4 +778,71 @@ public:
   ~channel_logs() {}
 };
 
+// Export channel transfers as Chrome trace-event JSON, for chrome://tracing or the Perfetto UI
+// (ui.perfetto.dev). Each Combinational channel becomes a track, and each message a slice from
+// its Push() to the moment it leaves the channel: the handshake with the consumer, or for a
+// back-annotated channel the cycle it leaves the channel buffer. Gaps between slices show the
+// pipeline bubbles. Unlike trace_hierarchy() nothing is recorded per cycle, and events are
+// appended to the file in bounded chunks while the simulation runs.
+//
+// include(), exclude(), include_regex() and exclude_regex() select channels by name pattern as
+// for channel_logs. Call close(),
+// or let the object go out of scope, after sc_start() returns to terminate the file.
+//
+// Example usage in sc_main()
+//
+//  Top top("top");
+//
+//  channel_trace_events events;
+//  events.enable("channels.json");
+//  events.include("top.noc.*");
+//  events.trace_hierarchy(top);
+//  sc_start();
+//  events.close();
+//
+class channel_trace_events : public Connections::channel_name_filter
+{
+public:
+#ifdef CONNECTIONS_SIM_ONLY
+  Connections::channel_trace_event_writer writer;
+  std::deque<Connections::channel_trace_track> tracks;
+#endif
+  int enable( const std::string &fname, std::size_t buffer_bytes = 1 << 20 ) {
+#ifdef CONNECTIONS_SIM_ONLY
+    if ( !writer.open(fname, buffer_bytes) ) {
+      std::cerr << "Cannot open file '" << fname << "'" << std::endl;
+      return 1;
+    }
+#endif
+    return 0;
+  }
+
+  void trace_hier_helper( sc_object *obj ) {
+#ifdef CONNECTIONS_SIM_ONLY
+    std::string name;
+    Connections::sc_trace_marker *p = dynamic_cast<Connections::sc_trace_marker *>(obj);
+    if ( p && writer.is_open() && p->trace_events_name(name) && selected(name) ) {
+      tracks.push_back(Connections::channel_trace_track(&writer, writer.add_track(name)));
+      p->set_trace_events(&tracks.back());
+    }
+    std::vector<sc_object *> children = obj->get_child_objects();
+    for ( unsigned i = 0; i < children.size(); i++ ) {
+      if ( children[i] ) {
+        trace_hier_helper(children[i]);
+      }
+    }
+#endif
+  }
+
+  void trace_hierarchy( sc_object &sc_obj ) {
+    trace_hier_helper(&sc_obj);
+  }
+
+  void close() {
+#ifdef CONNECTIONS_SIM_ONLY
+    writer.close();
+#endif
+  }
+};
+
 #endif // CONNECTIONS_TRACE_H
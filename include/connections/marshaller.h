@@ -157,7 +157,9 @@ public:
   /* Add a field to the glob, or extract it. */
   template <typename T, int FieldSize>
   void AddField(T &d) {
+#ifndef CONNECTIONS_DISABLE_MARSHALL_CHECKS
     CONNECTIONS_SIM_ONLY_ASSERT_MSG(cur_idx + FieldSize <= Size, "Field size exceeded Size. Is a message's width enum missing an element, and are all fields marshalled?");
+#endif
     if (is_marshalling) {
       sc_lv<FieldSize> bits;
       connections_cast_type_to_vector(d, FieldSize, bits);
@@ -172,11 +174,41 @@ public:
 
   /* Return the bit vector. */
   sc_lv<Size> GetResult() {
+#ifndef CONNECTIONS_DISABLE_MARSHALL_CHECKS
     CONNECTIONS_SIM_ONLY_ASSERT_MSG(cur_idx==Size, "Size doesn't match current index. Is a message's width enum missing an element, and are all fields marshalled?");
+#endif
     return glob.range(Size - 1, 0);
   }
 };
 
+/**
+ * \brief Marshaller<0> is a width probe: it only counts the bits a Marshall() call adds
+ * \ingroup Marshaller
+ *
+ * \par Overview
+ * No bits are stored, so running a type's Marshall() against it is cheap. It is used by
+ * marshall_width_check to validate a message type's width once.
+ *
+ */
+template <>
+class Marshaller<0>
+{
+  unsigned int cur_idx;
+
+public:
+  Marshaller() : cur_idx(0) {}
+
+  template <typename T, int FieldSize>
+  void AddField(T &d) {
+    cur_idx += FieldSize;
+  }
+
+  /* Return the number of bits marshalled so far. */
+  unsigned int GetIndex() const {
+    return cur_idx;
+  }
+};
+
 /**
  * \brief Generic Wrapped class: wraps different datatypes to communicate with Marshaller
  * \ingroup Marshaller
@@ -218,6 +250,48 @@ Marshaller<Size> &operator&(Marshaller<Size> &m, T &rhs) {
   return m;
 }
 
+/**
+ * \brief marshall_width_check: validates the width of a message type once
+ * \ingroup Marshaller
+ *
+ * \par Overview
+ * Runs Marshall() of Wrapped<T> against the Marshaller<0> width probe and checks that
+ * the number of marshalled bits matches Wrapped<T>::width. Only the first call per type
+ * does any work.
+ *
+ * Defining CONNECTIONS_DISABLE_MARSHALL_CHECKS removes the per-field checks in
+ * Marshaller::AddField() and Marshaller::GetResult() from every marshall. MARSHALL_PORT
+ * ports then call marshall_width_check at construction, so a mis-sized message is still
+ * reported, once, before simulation starts.
+ *
+ * \par A Simple Example
+ * \code
+ *  #include <connections/marshaller.h>
+ *
+ *  ...
+ *  marshall_width_check<mem_req_t>::check();
+ *
+ * \endcode
+ * \par
+ *
+ */
+template <typename T>
+class marshall_width_check
+{
+public:
+  static void check() {
+#ifndef __SYNTHESIS__
+    static bool done = false;
+    if (done) { return; }
+    done = true;
+    Marshaller<0> m;
+    Wrapped<T> w;
+    w.Marshall(m);
+    CONNECTIONS_SIM_ONLY_ASSERT_MSG(m.GetIndex() == Wrapped<T>::width, "Marshalled size doesn't match the message width. Is a message's width enum missing an element, and are all fields marshalled?");
+#endif
+  }
+};
+
 /* Wrapped class specialization for sc_lv.  */
 template <int Width>
 class Wrapped<sc_lv<Width> >
@@ -0,0 +1,396 @@
+/**************************************************************************
+ *                                                                        *
+ *  HLS Connections Library                                               *
+ *                                                                        *
+ *  Software Version: 2026.2                                              *
+ *                                                                        *
+ *  Release Date    : Tue May 12 21:38:26 PDT 2026                        *
+ *  Release Type    : Production Release                                  *
+ *  Release Build   : 2026.2.0                                            *
+ *                                                                        *
+ *  Copyright 2026 Siemens                                                *
+ *                                                                        *
+ **************************************************************************
+ *  Licensed under the Apache License, Version 2.0 (the "License");       *
+ *  you may not use this file except in compliance with the License.      * 
+ *  You may obtain a copy of the License at                               *
+ *                                                                        *
+ *      http://www.apache.org/licenses/LICENSE-2.0                        *
+ *                                                                        *
+ *  Unless required by applicable law or agreed to in writing, software   * 
+ *  distributed under the License is distributed on an "AS IS" BASIS,     * 
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or       *
+ *  implied.                                                              * 
+ *  See the License for the specific language governing permissions and   * 
+ *  limitations under the License.                                        *
+ **************************************************************************
+ *                                                                        *
+ *  The most recent version of this package is available at github.       *
+ *                                                                        *
+ *************************************************************************/
+
+//*****************************************************************************************
+// replay.h
+//
+// Replays binary channel logs into a block simulated in isolation: ReplaySource drives an
+// In<> port of the block with the messages recorded on its channel, ReplayChecker compares
+// what the block sends on an Out<> port with the recording.
+//
+//*****************************************************************************************
+
+#ifndef __CONNECTIONS__REPLAY_H__
+#define __CONNECTIONS__REPLAY_H__
+
+#include <string>
+#include <vector>
+#include <sstream>
+
+#include "connections.h"
+#include "port_scanner.h"
+#include "channel_log_reader.h"
+
+namespace Connections
+{
+
+#ifdef CONNECTIONS_SIM_ONLY
+
+  // A Connections port on the boundary of a block, see replay_boundary().
+  struct replay_port {
+    bool is_input;              // In<> port of the block, drive it with a ReplaySource
+    unsigned int width;         // marshalled message width
+    std::string port_name;      // data port of the block
+    std::string channel_name;   // channel the port is bound to in the full design
+  };
+
+  // Find the boundary ports of block, like port_scanner does for wrapper generation, together
+  // with the channel each one is bound to. Call once elaboration of the full design is complete,
+  // e.g. from start_of_simulation(). Like port_scanner, only sees MARSHALL_PORT ports, see
+  // examples/connections/AdderReplay.
+  inline void __replay_boundary(port_scanner &ps, sc_object *obj, sc_object *block, std::vector<replay_port> &ports)
+  {
+    replay_port rp;
+    sc_object *bound_to = 0;
+    if (in_port_marker *p = dynamic_cast<in_port_marker *>(obj)) {
+      p->end_of_elaboration();
+      if (p->bound_to && p->top_port && !ps.is_descendent_of(p->bound_to, block)) {
+        rp.is_input = true;
+        rp.width = p->w;
+        rp.port_name = p->_UTIL_DATNAME_->name();
+        bound_to = p->bound_to;
+      }
+    }
+    if (out_port_marker *p = dynamic_cast<out_port_marker *>(obj)) {
+      p->end_of_elaboration();
+      if (p->bound_to && p->top_port && !ps.is_descendent_of(p->bound_to, block)) {
+        rp.is_input = false;
+        rp.width = p->w;
+        rp.port_name = p->_UTIL_DATNAME_->name();
+        bound_to = p->bound_to;
+      }
+    }
+    if (bound_to) {
+      // bound_to is the channel's valid signal, named after the channel.
+      rp.channel_name = bound_to->name();
+      const char *suffixes[] = {"_" _COMBVLDNAMEINSTR_, "_" _COMBVLDNAMEOUTSTR_};
+      for (unsigned i = 0; i < 2; i++) {
+        std::string suffix(suffixes[i]);
+        std::string &cn = rp.channel_name;
+        if (cn.size() > suffix.size() && cn.compare(cn.size() - suffix.size(), suffix.size(), suffix) == 0) {
+          cn.erase(cn.size() - suffix.size());
+          break;
+        }
+      }
+      ports.push_back(rp);
+    }
+
+    std::vector<sc_object *> children = obj->get_child_objects();
+    for (unsigned i = 0; i < children.size(); i++) {
+      if (children[i]) { __replay_boundary(ps, children[i], block, ports); }
+    }
+  }
+
+  inline std::vector<replay_port> replay_boundary(sc_object &block)
+  {
+    port_scanner ps;
+    std::vector<replay_port> ports;
+    __replay_boundary(ps, &block, &block, ports);
+    return ports;
+  }
+
+  // Log number of a channel in a channel_logs_names.txt file. A Combinational is logged under
+  // the name of its back-annotation module, or of its output data signal when driven through
+  // an Out<> port. Returns -1 if it wasn't logged.
+  inline int replay_log_number(const std::string &names_path, const std::string &channel_name)
+  {
+    int num = channel_log_number(names_path, channel_name);
+    if (num < 0) { num = channel_log_number(names_path, channel_name + "_" _COMBDATNAMEOUTSTR_); }
+    if (num < 0) { num = channel_log_number(names_path, channel_name + "_comb_BA"); }
+    return num;
+  }
+
+  // Recorded messages of one channel, as marshalled bits and the time they were sent.
+  template <typename Message>
+  class __replay_log
+  {
+  public:
+    typedef Wrapped<Message> WMessage;
+    static const unsigned int width = WMessage::width;
+    typedef sc_lv<width> MsgBits;
+
+    std::vector<MsgBits> bits;
+    std::vector<sc_time> times;
+
+    void load(const char *owner, const std::string &log_path, int log_number) {
+      bits.clear();
+      times.clear();
+      if (log_number < 0) {
+        SC_REPORT_ERROR("CONNECTIONS-401", (std::string(owner) + ": channel not found in the channel log names").c_str());
+        return;
+      }
+
+      channel_log_reader reader;
+      if (!reader.open(log_path)) {
+        SC_REPORT_ERROR("CONNECTIONS-401", (std::string(owner) + ": " + reader.last_error()).c_str());
+        return;
+      }
+      // Times are exact in the log's resolution unit, 10^exp fs.
+      int exp = reader.resolution_exp();
+      double scale = 1;
+      for (int i = 0; i < exp % 3; i++) { scale *= 10; }
+      sc_time_unit unit = static_cast<sc_time_unit>(SC_FS + exp / 3);
+      unsigned int bytes = (width + 7) / 8;
+      bool width_ok = true;
+
+      std::vector<unsigned int> channels(1, (unsigned int)log_number);
+      bool ok = reader.for_each(channels, 0, ~0ull,
+        [&](const channel_log_record_header &hdr, const unsigned char *payload) {
+          if (hdr.bytes != bytes) {
+            width_ok = false;
+            return false;
+          }
+          sc_bv<width> bv;
+          for (unsigned int w = 0; w < (width + 31) / 32; w++) {
+            sc_digit d = 0;
+            for (unsigned int i = 0; i < 4 && 4 * w + i < bytes; i++) { d |= (sc_digit)payload[4 * w + i] << (8 * i); }
+            bv.set_word(w, d);
+          }
+          bits.push_back(MsgBits(bv));
+          times.push_back(sc_time((double)hdr.time * scale, unit));
+          return true;
+        });
+      if (!ok) {
+        SC_REPORT_ERROR("CONNECTIONS-401", (std::string(owner) + ": " + reader.last_error()).c_str());
+      } else if (!width_ok) {
+        SC_REPORT_ERROR("CONNECTIONS-401", (std::string(owner) + ": recorded message width doesn't match the port").c_str());
+        bits.clear();
+        times.clear();
+      }
+    }
+  };
+
+  /**
+   * \brief Drive an In<> port of a block with messages recorded in a binary channel log
+   * \ingroup Connections
+   *
+   * \tparam Message       DataType of the port
+   *
+   * \par Overview
+   *      Loads the messages recorded for one channel by channel_logs (CHANNEL_LOG_BINARY or
+   *      CHANNEL_LOG_INDEXED) and pushes each of them at its recorded simulation time, or as
+   *      soon after as the block accepts it. The clock must match the recording. The channel
+   *      is given by log number, or by name as found in channel_logs_names.txt, see
+   *      replay_boundary() to list the channels at a block's boundary in the full design.
+   *
+   * \par A Simple Example
+   * \code
+   *      #include <connections/replay.h>
+   *
+   *      ...
+   *      Connections::ReplaySource<Packet> src("src", "full_data.clog", "full_names.txt", "top.soc.noc_to_dma");
+   *      Connections::ReplayChecker<Packet> chk("chk", "full_data.clog", "full_names.txt", "top.soc.dma_to_noc");
+   *      Connections::Combinational<Packet> in_chan, out_chan;
+   *      src.clk(clk); src.rst(rst); src.out(in_chan); dma.in(in_chan);
+   *      chk.clk(clk); chk.rst(rst); dma.out(out_chan); chk.in(out_chan);
+   *      ...
+   * \endcode
+   * \par
+   *
+   */
+  template <typename Message>
+  class ReplaySource : public sc_module
+  {
+  public:
+    Out<Message> out;
+    sc_in<bool> clk;
+    sc_in<bool> rst;
+
+    SC_HAS_PROCESS(ReplaySource);
+
+    ReplaySource(sc_module_name name, const std::string &log_path, int log_number)
+      : sc_module(name), out("out"), clk("clk"), rst("rst"), next(0) {
+      log.load(this->name(), log_path, log_number);
+      init();
+    }
+
+    ReplaySource(sc_module_name name, const std::string &log_path, const std::string &names_path, const std::string &channel_name)
+      : sc_module(name), out("out"), clk("clk"), rst("rst"), next(0) {
+      log.load(this->name(), log_path, replay_log_number(names_path, channel_name));
+      init();
+    }
+
+    std::size_t size() const { return log.bits.size(); }
+    std::size_t sent() const { return next; }
+    bool done() const { return next == log.bits.size(); }
+
+  private:
+    __replay_log<Message> log;
+    std::size_t next;
+
+    void init() {
+      SC_THREAD(run);
+      sensitive << clk.pos();
+      async_reset_signal_is(rst, false);
+    }
+
+    void run() {
+      out.Reset();
+      next = 0;
+      wait();
+
+      while (next < log.bits.size()) {
+        while (sc_time_stamp() < log.times[next]) { wait(); }
+        out.Push(convert_from_lv<Message>(log.bits[next]));
+        next++;
+        wait();
+      }
+      while (1) { wait(); }
+    }
+  };
+
+  /**
+   * \brief Check the messages on an Out<> port of a block against a binary channel log
+   * \ingroup Connections
+   *
+   * \tparam Message       DataType of the port
+   *
+   * \par Overview
+   *      Pops every message and compares its marshalled bits with the next message recorded
+   *      for the channel, reporting mismatches and extra messages as errors. With check_timing,
+   *      messages received at another time than recorded are counted as well; the first is
+   *      reported as a warning. The log records a message at the clock edge it is pushed,
+   *      Pop() returns it one clock period of the port later, so that is the expected time. Messages still expected when the simulation ends are reported
+   *      then. See ReplaySource for how the channel is selected.
+   *
+   */
+  template <typename Message>
+  class ReplayChecker : public sc_module
+  {
+  public:
+    In<Message> in;
+    sc_in<bool> clk;
+    sc_in<bool> rst;
+
+    SC_HAS_PROCESS(ReplayChecker);
+
+    ReplayChecker(sc_module_name name, const std::string &log_path, int log_number, bool check_timing = false)
+      : sc_module(name), in("in"), clk("clk"), rst("rst"), check_timing(check_timing) {
+      log.load(this->name(), log_path, log_number);
+      init();
+    }
+
+    ReplayChecker(sc_module_name name, const std::string &log_path, const std::string &names_path,
+                  const std::string &channel_name, bool check_timing = false)
+      : sc_module(name), in("in"), clk("clk"), rst("rst"), check_timing(check_timing) {
+      log.load(this->name(), log_path, replay_log_number(names_path, channel_name));
+      init();
+    }
+
+    std::size_t size() const { return log.bits.size(); }
+    std::size_t checked() const { return next; }
+    unsigned long errors() const { return mismatches; }
+    unsigned long timing_errors() const { return timing_mismatches; }
+    bool done() const { return next >= log.bits.size(); }
+
+  private:
+    __replay_log<Message> log;
+    bool check_timing;
+    std::size_t next;
+    unsigned long mismatches;
+    unsigned long timing_mismatches;
+
+    void init() {
+      next = 0;
+      mismatches = 0;
+      timing_mismatches = 0;
+      SC_THREAD(run);
+      sensitive << clk.pos();
+      async_reset_signal_is(rst, false);
+    }
+
+    void run() {
+      in.Reset();
+      next = 0;
+      wait();
+
+      while (1) {
+        Message m = in.Pop();
+        check(m);
+        wait();
+      }
+    }
+
+    void check(const Message &m) {
+      std::ostringstream ss;
+      if (next >= log.bits.size()) {
+        mismatches++;
+        ss << name() << ": unexpected message " << next << " at " << sc_time_stamp() << ", the recording has " << log.bits.size();
+        SC_REPORT_ERROR("CONNECTIONS-402", ss.str().c_str());
+        next++;
+        return;
+      }
+      typename __replay_log<Message>::MsgBits bits = convert_to_lv<Message>(m);
+      if (bits != log.bits[next]) {
+        mismatches++;
+        ss << name() << ": message " << next << " at " << sc_time_stamp() << " is " << bits.to_string(SC_HEX)
+           << ", recorded " << log.bits[next].to_string(SC_HEX) << " at " << log.times[next];
+        SC_REPORT_ERROR("CONNECTIONS-402", ss.str().c_str());
+      } else if (check_timing && sc_time_stamp() != log.times[next] + clock_period()) {
+        if (timing_mismatches++ == 0) {
+          ss << name() << ": message " << next << " received at " << sc_time_stamp() << ", expected at "
+             << (log.times[next] + clock_period()) << " (recorded at " << log.times[next] << ")";
+          SC_REPORT_WARNING("CONNECTIONS-403", ss.str().c_str());
+        }
+      }
+      next++;
+    }
+
+    // Clock period of the in port as registered with the ConManager, or else of the clk port.
+    sc_time clock_period() {
+      Blocking_abs *port = dynamic_cast<Blocking_abs *>(&in);
+      std::vector<SimConnectionsClk::clk_info> &clks = ConManager_statics<void>::sim_clk.clk_info_vector;
+      if (port && port->clock_registered && port->clock_number < (int)clks.size()) {
+        return clks[port->clock_number].period_delay;
+      }
+      sc_clock *c = dynamic_cast<sc_clock *>(clk.get_interface());
+      return c ? c->period() : SC_ZERO_TIME;
+    }
+
+    void end_of_simulation() {
+      std::ostringstream ss;
+      if (next < log.bits.size()) {
+        ss << name() << ": " << (log.bits.size() - next) << " of " << log.bits.size() << " recorded messages not received";
+        SC_REPORT_WARNING("CONNECTIONS-403", ss.str().c_str());
+      }
+      if (timing_mismatches > 0) {
+        std::ostringstream ts;
+        ts << name() << ": " << timing_mismatches << " messages received at another time than recorded";
+        SC_REPORT_WARNING("CONNECTIONS-403", ts.str().c_str());
+      }
+    }
+  };
+
+#endif // CONNECTIONS_SIM_ONLY
+
+}  // namespace Connections
+
+#endif  // __CONNECTIONS__REPLAY_H__
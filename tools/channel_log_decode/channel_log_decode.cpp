@@ -0,0 +1,185 @@
+/**************************************************************************
+ *                                                                        *
+ *  HLS Connections Library                                               *
+ *                                                                        *
+ *  Software Version: 2026.2                                              *
+ *                                                                        *
+ *  Release Date    : Tue May 12 21:38:26 PDT 2026                        *
+ *  Release Type    : Production Release                                  *
+ *  Release Build   : 2026.2.0                                            *
+ *                                                                        *
+ *  Copyright 2026 Siemens                                                *
+ *                                                                        *
+ **************************************************************************
+ *  Licensed under the Apache License, Version 2.0 (the "License");       *
+ *  you may not use this file except in compliance with the License.      * 
+ *  You may obtain a copy of the License at                               *
+ *                                                                        *
+ *      http://www.apache.org/licenses/LICENSE-2.0                        *
+ *                                                                        *
+ *  Unless required by applicable law or agreed to in writing, software   * 
+ *  distributed under the License is distributed on an "AS IS" BASIS,     * 
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or       *
+ *  implied.                                                              * 
+ *  See the License for the specific language governing permissions and   * 
+ *  limitations under the License.                                        *
+ **************************************************************************
+ *                                                                        *
+ *  The most recent version of this package is available at github.       *
+ *                                                                        *
+ *************************************************************************/
+
+
+//*****************************************************************************************
+// channel_log_decode.cpp
+//
+// Decoder for binary channel logs written by channel_logs::enable() with CHANNEL_LOG_BINARY
+// (.bin) or CHANNEL_LOG_INDEXED (.clog). Prints the records in the text format of
+// channel_logs_data.txt:
+//   <log_number> | <message> | <time>
+// The message is printed as the hex value of its marshalled bits, which matches the text
+// log for integer message types. Structs print as their packed bits rather than through
+// their operator<<.
+//
+// Records can be selected by log number (see channel_logs_names.txt) and time window. For
+// .clog files only the blocks whose index entry matches are read and decompressed.
+//
+// Usage:
+//   ./channel_log_decode [-o <output file>] [-c <log_number>]... [--from <time>] [--to <time>] <log file>
+// Times are given with a unit, e.g. 100ns or 2.5us, or as a plain count of time resolution units.
+//*****************************************************************************************
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <connections/channel_log_reader.h>
+
+// Same formatting as sc_time::to_string(): the shortest integer or decimal value in the
+// largest unit that keeps it exact, e.g. "10 ns" or "2500 ps".
+static std::string format_time(unsigned long long value, int resolution_exp)
+{
+  static const char *units[] = { "fs", "ps", "ns", "us", "ms", "s" };
+  if (value == 0) { return "0 s"; }
+  int n = resolution_exp; // power of ten of one time unit in fs
+  while ((value % 10) == 0) {
+    value /= 10;
+    n++;
+  }
+  std::string result = std::to_string(value);
+  switch (n % 3) {
+    case 1: result += "0"; break;
+    case 2: result += "00"; break;
+  }
+  int u = n / 3;
+  for (; u > 5; u--) { result += "000"; }
+  return result + " " + units[u];
+}
+
+// Parse "<number>[fs|ps|ns|us|ms|s]" into time resolution units.
+static bool parse_time(const char *s, int resolution_exp, unsigned long long &value)
+{
+  static const char *units[] = { "fs", "ps", "ns", "us", "ms", "s" };
+  char *end;
+  double v = strtod(s, &end);
+  if (end == s || v < 0) { return false; }
+  if (*end == 0) {
+    value = (unsigned long long)v;
+    return true;
+  }
+  for (int u = 0; u < 6; u++) {
+    if (!strcmp(end, units[u])) {
+      value = (unsigned long long)(v * std::pow(10.0, 3 * u - resolution_exp) + 0.5);
+      return true;
+    }
+  }
+  return false;
+}
+
+static void format_payload(const unsigned char *payload, unsigned int bytes, std::string &out)
+{
+  static const char digits[] = "0123456789abcdef";
+  out.clear();
+  for (unsigned int i = bytes; i-- > 0; ) {
+    unsigned char b = payload[i];
+    if (out.empty()) {
+      if (b == 0) { continue; }
+      if (b >> 4) { out += digits[b >> 4]; }
+    } else {
+      out += digits[b >> 4];
+    }
+    out += digits[b & 0xf];
+  }
+  if (out.empty()) { out = "0"; }
+}
+
+static void usage(const char *argv0)
+{
+  std::cerr << "usage: " << argv0 << " [-o <output file>] [-c <log_number>]... [--from <time>] [--to <time>] <log file>\n";
+}
+
+int main(int argc, char *argv[])
+{
+  const char *in_path = 0;
+  const char *out_path = 0;
+  const char *from = 0;
+  const char *to = 0;
+  std::vector<unsigned int> channels; // sorted, empty selects all
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-o") && (i + 1 < argc)) { out_path = argv[++i]; }
+    else if (!strcmp(argv[i], "-c") && (i + 1 < argc)) { channels.push_back(strtoul(argv[++i], 0, 10)); }
+    else if (!strcmp(argv[i], "--from") && (i + 1 < argc)) { from = argv[++i]; }
+    else if (!strcmp(argv[i], "--to") && (i + 1 < argc)) { to = argv[++i]; }
+    else if (!in_path && argv[i][0] != '-') { in_path = argv[i]; }
+    else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (!in_path) {
+    usage(argv[0]);
+    return 1;
+  }
+  std::sort(channels.begin(), channels.end());
+
+  Connections::channel_log_reader reader;
+  if (!reader.open(in_path)) {
+    std::cerr << reader.last_error() << std::endl;
+    return 1;
+  }
+  int resolution_exp = reader.resolution_exp();
+  unsigned long long from_value = 0, to_value = ~0ull;
+  if ((from && !parse_time(from, resolution_exp, from_value)) || (to && !parse_time(to, resolution_exp, to_value))) {
+    std::cerr << "Cannot parse time '" << (from ? from : "") << "' / '" << (to ? to : "") << "'" << std::endl;
+    return 1;
+  }
+
+  std::ofstream ofs;
+  if (out_path) {
+    ofs.open(out_path);
+    if (!ofs.is_open()) {
+      std::cerr << "Cannot open file '" << out_path << "'" << std::endl;
+      return 1;
+    }
+  }
+  std::ostream &os = out_path ? static_cast<std::ostream &>(ofs) : std::cout;
+
+  std::string text;
+  bool ok = reader.for_each(channels, from_value, to_value,
+    [&](const Connections::channel_log_record_header &hdr, const unsigned char *payload) {
+      format_payload(payload, hdr.bytes, text);
+      os << hdr.log_number << " | " << text << " | " << format_time(hdr.time, resolution_exp) << "\n";
+      return true;
+    });
+  if (!ok) {
+    std::cerr << reader.last_error() << std::endl;
+    return 1;
+  }
+  return 0;
+}